@@ -0,0 +1,793 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "RingBuffer.h"
+#include "GpuHeap.h"
+#include "GLDeletionQueue.h"
+#include "HandlePool.h"
+#include "MeshOptimizer.h"
+#include "Meshlet.h"
+#include "VertexEncoding.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include "VertexArrayCache.h"
+#include "VertexPullBuffer.h"
+#include "GLCaps.h"
+#include "Framebuffer.h"
+#ifndef GL_DISPATCH_NULL_ONLY
+#include "HeadlessContext.h"
+#include "UploadService.h"
+#endif
+#include "Shader.h"
+#include "BenchmarkRunner.h"
+
+/**
+* Benchmarks for the engine's hot paths.
+*   --null          run against the null GL dispatch table, no context or driver needed (CPU cost only)
+*   --shader PATH   shader used by the shader and scene benchmarks
+*   --out PATH      JSON results file
+*   --min-time S    minimum seconds spent in each benchmark
+* Without --null it creates a HeadlessContext; on Linux configure CMake with -DGL_HEADLESS_BACKEND=EGL for a
+* software GL machine without a display.
+**/
+
+static const float s_QuadPositions[] = {
+    -0.5f, -0.5f,
+    0.5f,  -0.5f,
+    0.5f,   0.5f,
+    -0.5f,  0.5f,
+};
+
+static const unsigned int s_QuadIndices[] = {
+    0, 1, 2,
+    2, 3, 0
+};
+
+// Keeps results alive so the optimizer can't drop the work that produced them
+static volatile unsigned int s_Sink;
+
+struct LayoutVertex
+{
+    float position[3];
+    float uv[2];
+    unsigned char color[4];
+};
+
+static constexpr auto s_LayoutVertexLayout = MakeVertexLayout<LayoutVertex>(VERTEX_ELEMENT(LayoutVertex, position),
+    VERTEX_ELEMENT(LayoutVertex, uv), VERTEX_ELEMENT(LayoutVertex, color));
+
+static void RunLayoutBenchmarks(BenchmarkRunner& runner)
+{
+    runner.Run("VertexBufferLayout::Push/3 elements", []() {
+        VertexBufferLayout layout;
+        layout.Push<float>(3);
+        layout.Push<float>(2);
+        layout.Push<unsigned char>(4);
+        s_Sink = layout.GetStride();
+    });
+
+    runner.Run("VertexBufferLayout::Push/3 quantized elements", []() {
+        VertexBufferLayout layout;
+        layout.Push<Half>(4);
+        layout.Push<SNorm1010102>(4);
+        layout.Push<Half>(2);
+        s_Sink = layout.GetStride();
+    });
+
+    VertexArray va;
+    VertexBuffer vb(s_QuadPositions, sizeof(s_QuadPositions));
+    VertexBufferLayout layout;
+    layout.Push<float>(3);
+    layout.Push<float>(2);
+    layout.Push<unsigned char>(4);
+    runner.Run("VertexArray::AddBuffer/3 elements", [&]() {
+        va.AddBuffer(vb, layout);
+    });
+    runner.Run("VertexArray::AddBuffer/static 3 elements", [&]() {
+        va.AddBuffer(vb, s_LayoutVertexLayout);
+    });
+}
+
+// Encoding 64K float position/normal/uv vertices (32 bytes) into 16 byte quantized ones on each SIMD path,
+// then uploading both forms
+static void RunVertexEncodingBenchmarks(BenchmarkRunner& runner)
+{
+    const size_t count = 64 * 1024;
+    std::vector<float> positions(count * 3), normals(count * 3), uvs(count * 2);
+    for (size_t i = 0; i < count; i++) {
+        float angle = i * 0.001f;
+        float vertex[8] = { std::cos(angle) * 10.0f, (float)(i % 100), std::sin(angle) * 10.0f,
+            std::cos(angle), 0.0f, std::sin(angle), (i % 256) / 255.0f, (i / 256) / 255.0f };
+        memcpy(&positions[i * 3], vertex, 3 * sizeof(float));
+        memcpy(&normals[i * 3], vertex + 3, 3 * sizeof(float));
+        memcpy(&uvs[i * 2], vertex + 6, 2 * sizeof(float));
+    }
+
+    std::vector<QuantizedVertex> quantized(count);
+    SimdLevel detected = GetVertexEncoderSimd();
+    for (SimdLevel level : { SimdLevel::SSE2, SimdLevel::AVX2 }) {
+        SetVertexEncoderSimd(level);
+        if (GetVertexEncoderSimd() != level)
+            continue;
+        runner.Run(std::string("QuantizeVertices/64K ") + GetSimdLevelName(level), [&]() {
+            QuantizeVertices(quantized.data(), positions.data(), normals.data(), uvs.data(), count);
+        });
+    }
+    SetVertexEncoderSimd(detected);
+
+    std::vector<float> interleaved(count * 8);
+    for (size_t i = 0; i < count; i++) {
+        memcpy(&interleaved[i * 8], &positions[i * 3], 3 * sizeof(float));
+        memcpy(&interleaved[i * 8 + 3], &normals[i * 3], 3 * sizeof(float));
+        memcpy(&interleaved[i * 8 + 6], &uvs[i * 2], 2 * sizeof(float));
+    }
+    unsigned int floatSize = (unsigned int)(interleaved.size() * sizeof(float));
+    unsigned int quantizedSize = (unsigned int)(quantized.size() * sizeof(QuantizedVertex));
+    VertexBuffer floatBuffer(nullptr, floatSize, BufferUsage::Stream);
+    VertexBuffer quantizedBuffer(nullptr, quantizedSize, BufferUsage::Stream);
+    runner.Run("VertexBuffer::Update/64K float vertices", [&]() {
+        floatBuffer.Update(interleaved.data(), floatSize);
+    });
+    runner.Run("VertexBuffer::Update/64K quantized vertices", [&]() {
+        quantizedBuffer.Update(quantized.data(), quantizedSize);
+    });
+}
+
+// Vertex array setup for 1000 meshes sharing one heap page and layout: one array each versus the cache
+static void RunVertexArrayCacheBenchmarks(BenchmarkRunner& runner)
+{
+    GpuHeap heap;
+    std::vector<VertexBuffer> meshes;
+    meshes.reserve(1000);
+    for (unsigned int i = 0; i < 1000; i++)
+        meshes.emplace_back(heap, nullptr, (64 + (i % 7) * 16) * sizeof(LayoutVertex), (unsigned int)sizeof(LayoutVertex));
+
+    runner.Run("VertexArray per mesh/1000 meshes", [&]() {
+        for (const VertexBuffer& vb : meshes) {
+            VertexArray va;
+            va.AddBuffer(vb, s_LayoutVertexLayout);
+            s_Sink = va.GetRendererID();
+        }
+        GLDeletionQueue::Get().EndFrame();
+    });
+
+    VertexArrayCache cache;
+    runner.Run("VertexArrayCache::Get/1000 meshes", [&]() {
+        for (const VertexBuffer& vb : meshes)
+            s_Sink = cache.Get(vb, s_LayoutVertexLayout).GetRendererID();
+    });
+    const VertexArrayCache::Stats& stats = cache.GetStats();
+    std::cout << "[VertexArrayCache] " << stats.hits << " hits, " << stats.misses << " misses, "
+        << stats.vertexArrays << " vertex arrays for " << meshes.size() << " meshes" << std::endl;
+}
+
+// Creating a mesh's buffers and vertex array through binds versus by name, on each path the context supports
+static void RunDirectStateAccessBenchmarks(BenchmarkRunner& runner)
+{
+    std::vector<LayoutVertex> vertices(1024);
+    std::vector<unsigned int> indices(3 * 1024);
+    for (unsigned int i = 0; i < indices.size(); i++)
+        indices[i] = i % vertices.size();
+
+    bool supported = GLCaps::Get().directStateAccess;
+    for (bool dsa : { false, true }) {
+        if (dsa && !supported)
+            continue;
+        GLCaps::SetDirectStateAccess(dsa);
+        std::string path = dsa ? " DSA" : " bind";
+        runner.Run("Create mesh/" + std::to_string(vertices.size()) + " vertices" + path, [&]() {
+            {
+                VertexBuffer vb(vertices.data(), (unsigned int)(vertices.size() * sizeof(LayoutVertex)));
+                IndexBuffer ib(indices.data(), (unsigned int)indices.size());
+                VertexArray va;
+                va.AddBuffer(vb, s_LayoutVertexLayout);
+                va.SetIndexBuffer(ib);
+            }
+            GLDeletionQueue::Get().EndFrame();
+        });
+
+        VertexBuffer vb(nullptr, (unsigned int)(vertices.size() * sizeof(LayoutVertex)), BufferUsage::Dynamic);
+        runner.Run("VertexBuffer::Update/sub 4KB" + path, [&]() {
+            vb.Update(vertices.data(), 4096, 4096);
+        });
+    }
+    GLCaps::SetDirectStateAccess(supported);
+}
+
+// Switching between 1000 meshes sharing a layout, each in its own GL buffer: respecifying the attributes of one
+// vertex array per switch versus rebinding the buffer of a format-only array, with and without attribute bindings
+static void RunVertexAttribBindingBenchmarks(BenchmarkRunner& runner)
+{
+    std::vector<VertexBuffer> meshes;
+    meshes.reserve(1000);
+    for (unsigned int i = 0; i < 1000; i++)
+        meshes.emplace_back(nullptr, (64 + (i % 7) * 16) * (unsigned int)sizeof(LayoutVertex));
+
+    const GLCaps supported = GLCaps::Get();
+    GLCaps::SetDirectStateAccess(false);
+    for (bool binding : { false, true }) {
+        if (binding && !supported.vertexAttribBinding)
+            continue;
+        GLCaps::SetVertexAttribBinding(binding);
+        std::string path = binding ? " attrib binding" : " attrib pointer";
+        {
+            VertexArray va;
+            runner.Run("AddBuffer per mesh/1000 meshes" + path, [&]() {
+                for (const VertexBuffer& vb : meshes)
+                    va.AddBuffer(vb, s_LayoutVertexLayout);
+                s_Sink = va.GetBaseVertex();
+            });
+        }
+        VertexArrayCache cache;
+        VertexArray format = cache.GetFormat(s_LayoutVertexLayout);
+        runner.Run("BindVertexBuffer per mesh/1000 meshes" + path, [&]() {
+            for (const VertexBuffer& vb : meshes)
+                s_Sink = format.BindVertexBuffer(vb);
+        });
+    }
+    GLCaps::SetVertexAttribBinding(supported.vertexAttribBinding);
+    GLCaps::SetDirectStateAccess(supported.directStateAccess);
+    GLDeletionQueue::Get().EndFrame();
+}
+
+// Rewriting a whole buffer every frame: recreating it versus orphaning it through Update
+static void RunBufferUpdateBenchmarks(BenchmarkRunner& runner)
+{
+    std::vector<float> vertices(16 * 1024);
+    unsigned int size = (unsigned int)(vertices.size() * sizeof(float));
+    // Includes the deferred delete, one frame per iteration
+    runner.Run("VertexBuffer/recreate 64KB", [&]() {
+        {
+            VertexBuffer vb(vertices.data(), size);
+            s_Sink = vb.GetSize();
+        }
+        GLDeletionQueue::Get().EndFrame();
+    });
+
+    VertexBuffer stream(nullptr, size, BufferUsage::Stream);
+    runner.Run("VertexBuffer::Update/orphan 64KB", [&]() {
+        stream.Update(vertices.data(), size);
+    });
+    runner.Run("VertexBuffer::Update/sub 4KB", [&]() {
+        stream.Update(vertices.data(), 4096, 4096);
+    });
+
+    // One frame per iteration, so the ring cycles through its regions and waits on their fences like a real frame loop
+    RingBuffer ring(size);
+    VertexBuffer ringBacked(ring);
+    runner.Run("VertexBuffer::Update/ring 64KB", [&]() {
+        ringBacked.Update(vertices.data(), size);
+        ring.EndFrame();
+    });
+}
+
+// Mesh churn through the sub-allocator: 1000 small vertex + index allocations made then released
+static void RunHeapBenchmarks(BenchmarkRunner& runner)
+{
+    GpuHeap heap;
+    std::vector<GpuHeap::Allocation> allocations(2000);
+    runner.Run("GpuHeap::Allocate+Free/1000 meshes", [&]() {
+        for (unsigned int i = 0; i < 1000; i++) {
+            allocations[i * 2] = heap.Allocate(64 + (i % 7) * 48, 20);
+            allocations[i * 2 + 1] = heap.Allocate(24 + (i % 5) * 12, 4);
+        }
+        for (const GpuHeap::Allocation& allocation : allocations)
+            heap.Free(allocation.handle);
+    });
+}
+
+// Resources kept contiguous in a generational pool, destroyed out of order
+static void RunHandlePoolBenchmarks(BenchmarkRunner& runner)
+{
+    HandlePool<VertexArray> pool;
+    std::vector<Handle<VertexArray>> handles(1000);
+    runner.Run("HandlePool<VertexArray>::Create+Destroy/1000", [&]() {
+        for (Handle<VertexArray>& handle : handles)
+            handle = pool.Create();
+        for (unsigned int i = 0; i < handles.size(); i++)
+            pool.Destroy(handles[(i * 7919) % handles.size()]);
+        GLDeletionQueue::Get().EndFrame();
+    });
+}
+
+static void RunShaderBenchmarks(BenchmarkRunner& runner, const std::string& shaderPath)
+{
+    runner.Run("ParseShader", [&]() {
+        ShaderProgramSource source = ParseShader(shaderPath);
+        s_Sink = (unsigned int)source.VertexSource.size();
+    });
+
+    ShaderProgramSource source = ParseShader(shaderPath);
+    runner.Run("CreateShader", [&]() {
+        unsigned int program = CreateShader(source.VertexSource, source.FragmentSource);
+        GLCall(glDeleteProgram(program));
+    });
+}
+
+// gridSize^2 quads of position + uv, triangles shuffled the way an unoptimized exporter might leave them
+static MeshData CreateShuffledGrid(unsigned int gridSize)
+{
+    MeshData mesh;
+    mesh.vertexSize = 5 * sizeof(float);
+    mesh.positionOffset = 0;
+    for (unsigned int y = 0; y <= gridSize; y++) {
+        for (unsigned int x = 0; x <= gridSize; x++) {
+            float u = (float)x / gridSize, v = (float)y / gridSize;
+            float vertex[5] = { u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.0f, u, v };
+            mesh.vertices.insert(mesh.vertices.end(), (const uint8_t*)vertex, (const uint8_t*)(vertex + 5));
+        }
+    }
+
+    std::vector<unsigned int> quads(gridSize * gridSize);
+    for (unsigned int i = 0; i < quads.size(); i++)
+        quads[i] = i;
+    std::shuffle(quads.begin(), quads.end(), std::mt19937(42));
+    for (unsigned int quad : quads) {
+        unsigned int x = quad % gridSize, y = quad / gridSize;
+        unsigned int i0 = y * (gridSize + 1) + x, i1 = i0 + 1, i2 = i0 + gridSize + 1, i3 = i2 + 1;
+        for (unsigned int index : { i0, i1, i2, i1, i3, i2 })
+            mesh.indices.push_back(index);
+    }
+    return mesh;
+}
+
+// Times the optimizer itself, then draws the mesh before and after so the ACMR change shows up in GPU time
+static void RunMeshOptimizerBenchmarks(BenchmarkRunner& runner, const std::string& shaderPath)
+{
+    const MeshData source = CreateShuffledGrid(256);
+    runner.Run("OptimizeMesh/grid 256x256", [&]() {
+        MeshData mesh = source;
+        s_Sink = OptimizeMesh(mesh).after.transforms;
+    });
+
+    MeshData optimized = source;
+    MeshOptimizationReport report = OptimizeMesh(optimized);
+    report.Print(std::cout);
+
+    ShaderProgramSource shaderSource = ParseShader(shaderPath);
+    unsigned int shader = CreateShader(shaderSource.VertexSource, shaderSource.FragmentSource);
+    GLCall(int location = glGetUniformLocation(shader, "u_Color"));
+    UniformBlock uniforms;
+    uniforms.SetFloat4(location, 0.2f, 0.3f, 0.8f, 1.0f);
+
+    Renderer renderer;
+    for (const MeshData* mesh : { &source, (const MeshData*)&optimized }) {
+        VertexArray va;
+        VertexBuffer vb(mesh->vertices.data(), (unsigned int)mesh->vertices.size());
+        VertexBufferLayout layout;
+        layout.Push<float>(3);
+        layout.Push<float>(2);
+        va.AddBuffer(vb, layout);
+        IndexBuffer ib(mesh->indices.data(), (unsigned int)mesh->indices.size());
+
+        runner.Run(std::string("DrawMesh/grid 256x256 ") + (mesh == &source ? "shuffled" : "optimized"), [&]() {
+            for (unsigned int i = 0; i < 20; i++)
+                renderer.Submit(va, ib, shader, uniforms);
+            renderer.Flush();
+            GLDeletionQueue::Get().EndFrame();
+            GLCall(glFinish());
+        });
+    }
+
+    GLCall(glDeleteProgram(shader));
+}
+
+// Unit UV sphere of xyz positions
+static MeshData CreateSphere(unsigned int rings, unsigned int segments)
+{
+    MeshData mesh;
+    mesh.vertexSize = 3 * sizeof(float);
+    mesh.positionOffset = 0;
+    for (unsigned int ring = 0; ring <= rings; ring++) {
+        for (unsigned int segment = 0; segment <= segments; segment++) {
+            float theta = 3.14159265f * ring / rings, phi = 6.28318531f * segment / segments;
+            float vertex[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+            mesh.vertices.insert(mesh.vertices.end(), (const uint8_t*)vertex, (const uint8_t*)(vertex + 3));
+        }
+    }
+    for (unsigned int ring = 0; ring < rings; ring++) {
+        for (unsigned int segment = 0; segment < segments; segment++) {
+            unsigned int i0 = ring * (segments + 1) + segment, i1 = i0 + 1, i2 = i0 + segments + 1, i3 = i2 + 1;
+            for (unsigned int index : { i0, i2, i1, i1, i2, i3 })
+                mesh.indices.push_back(index);
+        }
+    }
+    return mesh;
+}
+
+// Culls the meshlets of a dense sphere seen from one side, then compares drawing the whole mesh against the visible ranges
+static void RunMeshletBenchmarks(BenchmarkRunner& runner, const std::string& shaderPath)
+{
+    MeshData mesh = CreateSphere(256, 512);
+    OptimizeMesh(mesh);
+    const float* positions = (const float*)(mesh.vertices.data() + mesh.positionOffset);
+    std::vector<Meshlet> meshlets = BuildMeshlets(mesh.indices.data(), (unsigned int)mesh.indices.size(), positions,
+        mesh.GetVertexCount(), mesh.vertexSize);
+
+    // The sphere fills the unit clip volume, seen from far along -z
+    const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    const float camera[3] = { 0.0f, 0.0f, -10.0f };
+    Frustum frustum = Frustum::FromMatrix(identity);
+    std::vector<MeshletDrawRange> ranges;
+    MeshletCullStats stats;
+    runner.Run("CullMeshlets/" + std::to_string(meshlets.size()) + " meshlets", [&]() {
+        ranges.clear();
+        stats = CullMeshlets(meshlets.data(), (unsigned int)meshlets.size(), frustum, camera, ranges);
+    });
+    std::cout << "[Meshlets] " << stats.visible << " visible, " << stats.backfaceCulled << " back facing, "
+        << stats.frustumCulled << " outside, " << stats.visibleTriangles << "/" << mesh.indices.size() / 3
+        << " triangles in " << ranges.size() << " draws" << std::endl;
+
+    ShaderProgramSource shaderSource = ParseShader(shaderPath);
+    unsigned int shader = CreateShader(shaderSource.VertexSource, shaderSource.FragmentSource);
+    GLCall(int location = glGetUniformLocation(shader, "u_Color"));
+    UniformBlock uniforms;
+    uniforms.SetFloat4(location, 0.8f, 0.3f, 0.2f, 1.0f);
+
+    VertexArray va;
+    VertexBuffer vb(mesh.vertices.data(), (unsigned int)mesh.vertices.size());
+    VertexBufferLayout layout;
+    layout.Push<float>(3);
+    va.AddBuffer(vb, layout);
+    IndexBuffer ib(mesh.indices.data(), (unsigned int)mesh.indices.size());
+
+    Renderer renderer;
+    runner.Run("DrawMeshlets/sphere all", [&]() {
+        renderer.Submit(va, ib, shader, uniforms);
+        renderer.Flush();
+        GLDeletionQueue::Get().EndFrame();
+        GLCall(glFinish());
+    });
+    runner.Run("DrawMeshlets/sphere culled", [&]() {
+        ranges.clear();
+        CullMeshlets(meshlets.data(), (unsigned int)meshlets.size(), frustum, camera, ranges);
+        for (const MeshletDrawRange& range : ranges)
+            renderer.SubmitRange(va, ib, range.firstIndex, range.indexCount, shader, uniforms);
+        renderer.Flush();
+        GLDeletionQueue::Get().EndFrame();
+        GLCall(glFinish());
+    });
+
+    GLCall(glDeleteProgram(shader));
+}
+
+// Pulled vertex shader: position is the first three words of every layout
+static const char* s_PulledVertexMain =
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4(PullVec3(PullVertex(PullMesh())), 1.0);\n"
+    "}\n";
+
+// 1000 small meshes alternating between two layouts: a vertex array each, versus pulling them from one buffer
+// through one attribute-less vertex array, drawn mesh by mesh and as a single merged draw
+static void RunVertexPullingBenchmarks(BenchmarkRunner& runner, const std::string& shaderPath)
+{
+    const unsigned int meshCount = 1000, vertexCount = 64, triangleCount = 96;
+    std::vector<std::vector<float>> vertices(meshCount);
+    std::vector<unsigned int> indices(triangleCount * 3);
+    for (unsigned int mesh = 0; mesh < meshCount; mesh++) {
+        unsigned int floats = mesh % 2 ? 5 : 3;	// xyz or xyz + uv
+        for (unsigned int i = 0; i < vertexCount; i++) {
+            float angle = i * 6.28318531f / vertexCount;
+            float vertex[5] = { std::cos(angle) * 0.01f + (mesh % 40) / 20.0f - 1.0f,
+                std::sin(angle) * 0.01f + (mesh / 40) / 12.5f - 1.0f, 0.0f, 0.5f, 0.5f };
+            vertices[mesh].insert(vertices[mesh].end(), vertex, vertex + floats);
+        }
+    }
+    for (unsigned int i = 0; i < indices.size(); i++)
+        indices[i] = (i * 7) % vertexCount;
+
+    ShaderProgramSource source = ParseShader(shaderPath);
+    unsigned int shader = CreateShader(source.VertexSource, source.FragmentSource);
+    GLCall(int location = glGetUniformLocation(shader, "u_Color"));
+    UniformBlock uniforms;
+    uniforms.SetFloat4(location, 0.2f, 0.8f, 0.3f, 1.0f);
+
+    Renderer renderer;
+    {
+        VertexBufferLayout layouts[2];
+        layouts[0].Push<float>(3);
+        layouts[1].Push<float>(3);
+        layouts[1].Push<float>(2);
+        std::vector<VertexBuffer> vbs;
+        std::vector<IndexBuffer> ibs;
+        std::vector<VertexArray> vas;
+        for (unsigned int mesh = 0; mesh < meshCount; mesh++) {
+            vbs.emplace_back(vertices[mesh].data(), (unsigned int)(vertices[mesh].size() * sizeof(float)));
+            ibs.emplace_back(indices.data(), (unsigned int)indices.size());
+            vas.emplace_back();
+            vas.back().AddBuffer(vbs.back(), layouts[mesh % 2]);
+        }
+        runner.Run("VertexPulling/1000 meshes vertex array each", [&]() {
+            for (unsigned int mesh = 0; mesh < meshCount; mesh++)
+                renderer.Submit(vas[mesh], ibs[mesh], shader, uniforms);
+            renderer.Flush();
+            GLDeletionQueue::Get().EndFrame();
+            GLCall(glFinish());
+        });
+    }
+
+    VertexPullBuffer pull(meshCount * vertexCount * 5 * sizeof(float));
+    std::vector<unsigned int> pulledIndices(meshCount * indices.size());
+    for (unsigned int mesh = 0; mesh < meshCount; mesh++) {
+        unsigned int id = pull.AddMesh(vertices[mesh].data(), vertexCount, (mesh % 2 ? 5 : 3) * sizeof(float), mesh % 2);
+        pull.EncodeIndices(id, indices.data(), (unsigned int)indices.size(), &pulledIndices[mesh * indices.size()]);
+    }
+    IndexBuffer pulledIB(pulledIndices.data(), (unsigned int)pulledIndices.size());
+    pull.SetIndexBuffer(pulledIB);
+
+    unsigned int pulledShader = CreateShader(VertexPullBuffer::GetShaderPrologue(pull.GetSource()) + s_PulledVertexMain,
+        source.FragmentSource);
+    pull.SetupProgram(pulledShader);
+    GLCall(int pulledLocation = glGetUniformLocation(pulledShader, "u_Color"));
+    UniformBlock pulledUniforms;
+    pulledUniforms.SetFloat4(pulledLocation, 0.2f, 0.8f, 0.3f, 1.0f);
+
+    std::string path = std::string(" ") + GetVertexPullSourceName(pull.GetSource());
+    runner.Run("VertexPulling/1000 meshes pulled" + path, [&]() {
+        pull.Bind();
+        for (unsigned int mesh = 0; mesh < meshCount; mesh++)
+            renderer.SubmitRange(pull.GetVertexArray(), pulledIB, mesh * (unsigned int)indices.size(),
+                (unsigned int)indices.size(), pulledShader, pulledUniforms);
+        renderer.Flush();
+        GLDeletionQueue::Get().EndFrame();
+        GLCall(glFinish());
+    });
+    runner.Run("VertexPulling/1000 meshes merged draw" + path, [&]() {
+        pull.Bind();
+        renderer.Submit(pull.GetVertexArray(), pulledIB, pulledShader, pulledUniforms);
+        renderer.Flush();
+        GLDeletionQueue::Get().EndFrame();
+        GLCall(glFinish());
+    });
+
+    GLCall(glDeleteProgram(pulledShader));
+    GLCall(glDeleteProgram(shader));
+}
+
+// Draws the same quad quadCount times per iteration through the renderer, waiting for the GPU to finish
+static void RunSceneBenchmark(BenchmarkRunner& runner, const std::string& shaderPath, unsigned int quadCount)
+{
+    VertexArray va;
+    VertexBuffer vb(s_QuadPositions, sizeof(s_QuadPositions));
+    VertexBufferLayout layout;
+    layout.Push<float>(2);
+    va.AddBuffer(vb, layout);
+    IndexBuffer ib(s_QuadIndices, 6);
+
+    ShaderProgramSource source = ParseShader(shaderPath);
+    unsigned int shader = CreateShader(source.VertexSource, source.FragmentSource);
+    GLCall(int location = glGetUniformLocation(shader, "u_Color"));
+
+    Renderer renderer;
+    runner.Run("Scene/quads=" + std::to_string(quadCount), [&]() {
+        renderer.Clear();
+        for (unsigned int i = 0; i < quadCount; i++) {
+            UniformBlock uniforms;
+            uniforms.SetFloat4(location, (i % 256) / 255.0f, 1.0f, 0.12f, 1.0f);
+            renderer.Submit(va, ib, shader, uniforms);
+        }
+        renderer.Flush();
+        GLDeletionQueue::Get().EndFrame();
+        GLCall(glFinish());
+    });
+
+    GLCall(glDeleteProgram(shader));
+}
+
+// Basic.shader's vertex stage with a per-instance offset, the quads shrunk so the copies spread over the target
+static const char* s_InstancedVertexShader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 position;\n"
+    "layout(location = 1) in vec2 offset;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4(position * 0.01 + offset, 0.0, 1.0);\n"
+    "}\n";
+
+// The quad of RunSceneBenchmark drawn quadCount times in a single instanced draw, compare with Scene/quads=quadCount
+static void RunInstancedSceneBenchmark(BenchmarkRunner& runner, const std::string& shaderPath, unsigned int quadCount)
+{
+    std::vector<float> offsets(quadCount * 2);
+    for (unsigned int i = 0; i < quadCount; i++) {
+        offsets[i * 2] = (i % 400) / 200.0f - 1.0f;
+        offsets[i * 2 + 1] = (i / 400 % 250) / 125.0f - 1.0f;
+    }
+
+    VertexArray va;
+    VertexBuffer vb(s_QuadPositions, sizeof(s_QuadPositions));
+    VertexBufferLayout layout;
+    layout.Push<float>(2);
+    va.AddBuffer(vb, layout);
+    VertexBuffer instances(offsets.data(), (unsigned int)(offsets.size() * sizeof(float)));
+    VertexBufferLayout instanceLayout;
+    instanceLayout.PushInstanced<float>(2);
+    va.AddBuffer(instances, instanceLayout);
+    IndexBuffer ib(s_QuadIndices, 6);
+
+    ShaderProgramSource source = ParseShader(shaderPath);
+    unsigned int shader = CreateShader(s_InstancedVertexShader, source.FragmentSource);
+    GLCall(int location = glGetUniformLocation(shader, "u_Color"));
+    UniformBlock uniforms;
+    uniforms.SetFloat4(location, 0.5f, 1.0f, 0.12f, 1.0f);
+
+    Renderer renderer;
+    runner.Run("Scene/quads=" + std::to_string(quadCount) + " instanced", [&]() {
+        renderer.Clear();
+        renderer.SubmitInstanced(va, ib, quadCount, shader, uniforms);
+        renderer.Flush();
+        GLDeletionQueue::Get().EndFrame();
+        GLCall(glFinish());
+    });
+
+    GLCall(glDeleteProgram(shader));
+}
+
+#ifndef GL_DISPATCH_NULL_ONLY
+/**
+* A frame of quadCount quads that loads a 4 MB mesh every 8th frame, on the render thread or through UploadService.
+* Compare the max column: created in place the whole copy lands in its frame, the service only copies to its queue.
+**/
+static void RunUploadBenchmarks(BenchmarkRunner& runner, const HeadlessContext& context, const std::string& shaderPath, unsigned int quadCount)
+{
+    const unsigned int loadInterval = 8;
+    std::vector<float> mesh(1024 * 1024);
+    for (size_t i = 0; i < mesh.size(); i++)
+        mesh[i] = (i % 1000) / 1000.0f;
+    const unsigned int meshSize = (unsigned int)(mesh.size() * sizeof(float));
+
+    VertexArray va;
+    VertexBuffer vb(s_QuadPositions, sizeof(s_QuadPositions));
+    VertexBufferLayout layout;
+    layout.Push<float>(2);
+    va.AddBuffer(vb, layout);
+    IndexBuffer ib(s_QuadIndices, 6);
+
+    ShaderProgramSource source = ParseShader(shaderPath);
+    unsigned int shader = CreateShader(source.VertexSource, source.FragmentSource);
+    GLCall(int location = glGetUniformLocation(shader, "u_Color"));
+
+    Renderer renderer;
+    auto drawFrame = [&]() {
+        renderer.Clear();
+        for (unsigned int i = 0; i < quadCount; i++) {
+            UniformBlock uniforms;
+            uniforms.SetFloat4(location, (i % 256) / 255.0f, 1.0f, 0.12f, 1.0f);
+            renderer.Submit(va, ib, shader, uniforms);
+        }
+        renderer.Flush();
+        GLDeletionQueue::Get().EndFrame();
+        GLCall(glFinish());
+    };
+
+    // Like a streaming scene, the last few loaded meshes stay alive and the oldest is dropped
+    std::deque<VertexBuffer> loaded;
+    auto keep = [&](VertexBuffer&& buffer) {
+        loaded.push_back(std::move(buffer));
+        if (loaded.size() > 4)
+            loaded.pop_front();
+    };
+
+    const std::string name = "Upload/quads=" + std::to_string(quadCount) + " +4MB every " + std::to_string(loadInterval);
+    unsigned int frame = 0;
+    runner.Run(name + " in place", [&]() {
+        if (frame++ % loadInterval == 0)
+            keep(VertexBuffer(mesh.data(), meshSize));
+        drawFrame();
+    });
+
+    {
+        UploadService uploads(context);
+        frame = 0;
+        runner.Run(name + " service", [&]() {
+            if (frame++ % loadInterval == 0)
+                uploads.UploadVertices(mesh.data(), meshSize, BufferUsage::Static, keep);
+            uploads.Poll();
+            drawFrame();
+        });
+        // Take over what is still in flight before the worker goes away
+        while (uploads.GetInFlightCount()) {
+            uploads.Poll();
+            std::this_thread::yield();
+        }
+    }
+    loaded.clear();
+
+    GLCall(glDeleteProgram(shader));
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    bool useNullGL = false;
+    std::string shaderPath = "res/shaders/Basic.shader";
+    std::string outputPath = "benchmark_results.json";
+    double minSeconds = 0.25;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--null") == 0)
+            useNullGL = true;
+        else if (strcmp(argv[i], "--shader") == 0 && i + 1 < argc)
+            shaderPath = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outputPath = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            minSeconds = atof(argv[++i]);
+    }
+
+#ifdef GL_DISPATCH_NULL_ONLY
+    // Built without GLEW and a context backend, the null table is all there is
+    if (!useNullGL)
+        std::cout << "Built without a GL backend, --null is implied" << std::endl;
+    GLDispatchLoadNull();
+    std::string contextName = "null GL";
+#else
+    HeadlessContext context;
+    std::string contextName;
+    if (useNullGL) {
+        GLDispatchLoadNull();
+        contextName = "null GL";
+    }
+    else {
+        if (!context.Create(640, 480)) {
+            std::cout << "Failed to create a headless context (" << HeadlessContext::GetBackendName() << ")" << std::endl;
+            return -1;
+        }
+        GLenum glewError = HeadlessContext::InitGLEW();
+        if (glewError != GLEW_OK) {
+            std::cout << "GLEW : " << glewGetErrorString(glewError) << std::endl;
+            return -1;
+        }
+        GLDispatchLoadDriver();
+        contextName = std::string(HeadlessContext::GetBackendName()) + ", " + (const char*)glGetString(GL_RENDERER);
+    }
+#endif
+    std::cout << "CONTEXT : " << contextName << std::endl;
+
+    BenchmarkRunner runner(contextName, minSeconds);
+    {
+        Framebuffer target(640, 480);
+        target.Bind();
+
+        RunLayoutBenchmarks(runner);
+        RunBufferUpdateBenchmarks(runner);
+        RunVertexEncodingBenchmarks(runner);
+        RunHeapBenchmarks(runner);
+        RunVertexArrayCacheBenchmarks(runner);
+        RunDirectStateAccessBenchmarks(runner);
+        RunVertexAttribBindingBenchmarks(runner);
+        RunHandlePoolBenchmarks(runner);
+        RunShaderBenchmarks(runner, shaderPath);
+        RunMeshOptimizerBenchmarks(runner, shaderPath);
+        RunMeshletBenchmarks(runner, shaderPath);
+        RunVertexPullingBenchmarks(runner, shaderPath);
+        for (unsigned int quadCount : { 1u, 1000u, 100000u })
+            RunSceneBenchmark(runner, shaderPath, quadCount);
+        RunInstancedSceneBenchmark(runner, shaderPath, 100000);
+#ifndef GL_DISPATCH_NULL_ONLY
+        // The worker needs a context to share with, the null table has none
+        if (!useNullGL)
+            RunUploadBenchmarks(runner, context, shaderPath, 1000);
+#endif
+    }
+    GLDeletionQueue::Get().Flush();
+
+    runner.Print(std::cout);
+    if (!runner.WriteJson(outputPath)) {
+        std::cout << "Failed to write " << outputPath << std::endl;
+        return -1;
+    }
+    std::cout << "Results written to " << outputPath << std::endl;
+    return 0;
+}
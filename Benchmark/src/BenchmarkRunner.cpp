@@ -0,0 +1,52 @@
+#include "BenchmarkRunner.h"
+#include "GLDispatch.h"
+#include <fstream>
+#include <iomanip>
+
+BenchmarkRunner::BenchmarkRunner(const std::string& context, double minSeconds)
+    : m_Context(context), m_MinSeconds(minSeconds)
+{
+}
+
+// One extra untimed iteration through the recording dispatch table, deterministic whatever the driver
+int64_t BenchmarkRunner::CountGLCalls(void (*invoke)(void*), void* fn)
+{
+    GLDispatchSetRecording(true);
+    GLDispatchResetCallCounts();
+    invoke(fn);
+    int64_t calls = GLDispatchGetTotalCallCount();
+    GLDispatchSetRecording(false);
+    return calls;
+}
+
+void BenchmarkRunner::Print(std::ostream& stream) const
+{
+    std::ios_base::fmtflags flags = stream.flags();
+    stream << std::left << std::setw(40) << "benchmark" << std::right << std::setw(12) << "median ns"
+        << std::setw(12) << "p95 ns" << std::setw(12) << "max ns" << std::setw(12) << "iterations" << std::setw(10) << "GL calls" << std::endl;
+    stream << std::fixed << std::setprecision(1);
+    for (const BenchmarkResult& result : m_Results) {
+        stream << std::left << std::setw(40) << result.name << std::right << std::setw(12) << result.medianNs
+            << std::setw(12) << result.p95Ns << std::setw(12) << result.maxNs << std::setw(12) << result.iterations << std::setw(10) << result.glCalls << std::endl;
+    }
+    stream.flags(flags);
+}
+
+bool BenchmarkRunner::WriteJson(const std::string& path) const
+{
+    std::ofstream stream(path);
+    if (!stream)
+        return false;
+
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\n  \"context\": \"" << m_Context << "\",\n  \"results\": [";
+    for (size_t i = 0; i < m_Results.size(); i++) {
+        const BenchmarkResult& result = m_Results[i];
+        stream << (i ? ",\n" : "\n") << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+            << ", \"mean_ns\": " << result.meanNs << ", \"median_ns\": " << result.medianNs
+            << ", \"min_ns\": " << result.minNs << ", \"p95_ns\": " << result.p95Ns << ", \"max_ns\": " << result.maxNs
+            << ", \"gl_calls\": " << result.glCalls << "}";
+    }
+    stream << "\n  ]\n}\n";
+    return true;
+}
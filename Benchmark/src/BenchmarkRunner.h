@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct BenchmarkResult
+{
+	std::string name;
+	uint64_t iterations;
+	double meanNs;
+	double medianNs;
+	double minNs;
+	double p95Ns;
+	double maxNs;	// the worst sample, where a one-off hitch shows up
+	int64_t glCalls; // GL calls made by one iteration, -1 when not counted
+};
+
+/**
+* Minimal timing harness: runs a function until enough time has passed and keeps per-iteration statistics.
+* Functions faster than a timer tick are batched, each sample then covers several iterations.
+**/
+class BenchmarkRunner
+{
+	private:
+		std::string m_Context;
+		double m_MinSeconds;
+		std::vector<BenchmarkResult> m_Results;
+
+		static int64_t CountGLCalls(void (*invoke)(void*), void* fn);
+
+	public:
+		BenchmarkRunner(const std::string& context, double minSeconds = 0.25);
+
+		template<typename F>
+		const BenchmarkResult& Run(const std::string& name, F&& fn)
+		{
+			using Clock = std::chrono::steady_clock;
+			const double minSampleNs = 20000.0;
+
+			// Warm up caches and lazily created driver objects, and size the batch
+			Clock::time_point start = Clock::now();
+			fn();
+			double firstNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			uint64_t batch = firstNs >= minSampleNs ? 1 : (uint64_t)(minSampleNs / std::max(firstNs, 1.0)) + 1;
+
+			std::vector<double> samples;
+			uint64_t iterations = 0;
+			Clock::time_point runStart = Clock::now();
+			do {
+				Clock::time_point sampleStart = Clock::now();
+				for (uint64_t i = 0; i < batch; i++)
+					fn();
+				samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - sampleStart).count() / batch);
+				iterations += batch;
+			} while (std::chrono::duration<double>(Clock::now() - runStart).count() < m_MinSeconds);
+
+			std::sort(samples.begin(), samples.end());
+			double sum = 0.0;
+			for (double sample : samples)
+				sum += sample;
+
+			auto invoke = [](void* f) { (*static_cast<F*>(f))(); };
+			m_Results.push_back({ name, iterations, sum / samples.size(), samples[samples.size() / 2], samples.front(),
+				samples[(size_t)(0.95 * (samples.size() - 1))], samples.back(), CountGLCalls(invoke, &fn) });
+			return m_Results.back();
+		}
+
+		void Print(std::ostream& stream) const;
+		bool WriteJson(const std::string& path) const;
+};
@@ -0,0 +1,166 @@
+#include "CommandList.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include "WorkerPool.h"
+
+// Program value that never matches, the first UseProgram of a list is always recorded
+static const unsigned int NoProgram = 0xFFFFFFFF;
+
+CommandList::CommandList()
+    : m_DrawCount(0), m_Program(NoProgram), m_VertexArray(nullptr), m_IndexBuffer(nullptr)
+{
+}
+
+void CommandList::Reset()
+{
+    m_Data.clear();
+    m_DrawCount = 0;
+    m_Program = NoProgram;
+    m_VertexArray = nullptr;
+    m_IndexBuffer = nullptr;
+}
+
+void CommandList::UseProgram(unsigned int program)
+{
+    if (m_Program == program)
+        return;
+    m_Program = program;
+    Write(Op::UseProgram);
+    Write(program);
+}
+
+void CommandList::BindVertexArray(const VertexArray& va)
+{
+    if (m_VertexArray == &va)
+        return;
+    m_VertexArray = &va;
+    // The element buffer binding belongs to the VAO, the next index buffer bind can't be skipped anymore
+    m_IndexBuffer = nullptr;
+    Write(Op::BindVertexArray);
+    Write(&va);
+}
+
+void CommandList::BindIndexBuffer(const IndexBuffer& ib)
+{
+    if (m_IndexBuffer == &ib)
+        return;
+    m_IndexBuffer = &ib;
+    Write(Op::BindIndexBuffer);
+    Write(&ib);
+}
+
+void CommandList::BindTexture(unsigned int unit, unsigned int texture)
+{
+    Write(Op::BindTexture);
+    Write(unit);
+    Write(texture);
+}
+
+void CommandList::SetUniform1f(int location, float x)
+{
+    Write(Op::Uniform1f);
+    Write(location);
+    Write(x);
+}
+
+void CommandList::SetUniform4f(int location, float x, float y, float z, float w)
+{
+    Write(Op::Uniform4f);
+    Write(location);
+    const float v[4] = { x, y, z, w };
+    Write(v);
+}
+
+void CommandList::SetUniform1i(int location, int x)
+{
+    Write(Op::Uniform1i);
+    Write(location);
+    Write(x);
+}
+
+void CommandList::DrawIndexed(const IndexBuffer& ib)
+{
+    DrawIndexed(ib, 0, ib.GetCount());
+}
+
+void CommandList::DrawIndexed(const IndexBuffer& ib, unsigned int firstIndex, unsigned int indexCount)
+{
+    ASSERT(firstIndex + indexCount <= ib.GetCount());
+    BindIndexBuffer(ib);
+    Write(Op::DrawElements);
+    ASSERT(m_VertexArray);
+    Write(ib.GetGLTopology());
+    Write(ib.GetGLType());
+    Write(ib.GetRestartIndex());
+    Write(indexCount);
+    Write(ib.GetOffset() + firstIndex * ib.GetIndexSize());
+    Write(m_VertexArray->GetBaseVertex());
+    m_DrawCount++;
+}
+
+void CommandList::Execute() const
+{
+    GLStateCache& state = GLStateCache::Get();
+    const uint8_t* cursor = m_Data.data();
+    const uint8_t* end = cursor + m_Data.size();
+    while (cursor < end) {
+        switch (Read<Op>(cursor)) {
+            case Op::UseProgram:
+                state.UseProgram(Read<unsigned int>(cursor));
+                break;
+            case Op::BindVertexArray:
+                Read<const VertexArray*>(cursor)->Bind();
+                break;
+            case Op::BindIndexBuffer:
+                Read<const IndexBuffer*>(cursor)->Bind();
+                break;
+            case Op::BindTexture: {
+                unsigned int unit = Read<unsigned int>(cursor);
+                state.BindTexture(unit, GL_TEXTURE_2D, Read<unsigned int>(cursor));
+                break;
+            }
+            case Op::Uniform1f: {
+                int location = Read<int>(cursor);
+                GLCall(glUniform1f(location, Read<float>(cursor)));
+                break;
+            }
+            case Op::Uniform4f: {
+                int location = Read<int>(cursor);
+                float v[4];
+                memcpy(v, cursor, sizeof(v));
+                cursor += sizeof(v);
+                GLCall(glUniform4fv(location, 1, v));
+                break;
+            }
+            case Op::Uniform1i: {
+                int location = Read<int>(cursor);
+                GLCall(glUniform1i(location, Read<int>(cursor)));
+                break;
+            }
+            case Op::DrawElements: {
+                unsigned int mode = Read<unsigned int>(cursor);
+                unsigned int type = Read<unsigned int>(cursor);
+                state.SetPrimitiveRestart(Read<unsigned int>(cursor));
+                unsigned int count = Read<unsigned int>(cursor);
+                uintptr_t offset = Read<unsigned int>(cursor);
+                int baseVertex = Read<int>(cursor);
+                GLCall(glDrawElementsBaseVertex(mode, count, type, (void*)offset, baseVertex));
+                break;
+            }
+        }
+    }
+}
+
+void CommandList::RecordParallel(WorkerPool& pool, std::vector<CommandList>& lists, unsigned int itemCount,
+    const std::function<void(CommandList& list, unsigned int begin, unsigned int end)>& record)
+{
+    const unsigned int listCount = (unsigned int)lists.size();
+    pool.ParallelFor(listCount, [&](unsigned int i) {
+        unsigned int begin = (unsigned int)((uint64_t)itemCount * i / listCount);
+        unsigned int end = (unsigned int)((uint64_t)itemCount * (i + 1) / listCount);
+        lists[i].Reset();
+        record(lists[i], begin, end);
+    });
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+class VertexArray;
+class IndexBuffer;
+class WorkerPool;
+
+/**
+* Compact binary stream of bind, uniform and draw commands.
+* Recording makes no GL calls so any thread can fill a list, Execute must run on the thread owning the context.
+* Referenced vertex arrays and index buffers must outlive the replay.
+**/
+class CommandList
+{
+	private:
+		enum class Op : uint8_t
+		{
+			UseProgram,
+			BindVertexArray,
+			BindIndexBuffer,
+			BindTexture,
+			Uniform1f,
+			Uniform4f,
+			Uniform1i,
+			DrawElements
+		};
+
+		std::vector<uint8_t> m_Data;
+		unsigned int m_DrawCount;
+
+		// Last state recorded, lets the stream drop redundant binds before they even reach the state cache
+		unsigned int m_Program;
+		const VertexArray* m_VertexArray;
+		const IndexBuffer* m_IndexBuffer;
+
+		template<typename T>
+		inline void Write(const T& value)
+		{
+			size_t offset = m_Data.size();
+			m_Data.resize(offset + sizeof(T));
+			memcpy(&m_Data[offset], &value, sizeof(T));
+		}
+
+		template<typename T>
+		static inline T Read(const uint8_t*& cursor)
+		{
+			T value;
+			memcpy(&value, cursor, sizeof(T));
+			cursor += sizeof(T);
+			return value;
+		}
+
+	public:
+		CommandList();
+
+		// Empties the list but keeps its memory for the next frame
+		void Reset();
+
+		void UseProgram(unsigned int program);
+		void BindVertexArray(const VertexArray& va);
+		void BindIndexBuffer(const IndexBuffer& ib);
+		void BindTexture(unsigned int unit, unsigned int texture);
+
+		void SetUniform1f(int location, float x);
+		void SetUniform4f(int location, float x, float y, float z, float w);
+		void SetUniform1i(int location, int x);
+
+		// Draws the whole index buffer with its topology and index type, offset by the bound vertex array's base vertex
+		void DrawIndexed(const IndexBuffer& ib);
+		// Same for indexCount indices starting at firstIndex
+		void DrawIndexed(const IndexBuffer& ib, unsigned int firstIndex, unsigned int indexCount);
+
+		// Replays every command in recording order, GL thread only
+		void Execute() const;
+
+		/**
+		* Splits [0, itemCount) into one contiguous range per list and records the ranges on the pool in parallel.
+		* Lists are reset first, replaying them in vector order gives the same result as recording sequentially.
+		**/
+		static void RecordParallel(WorkerPool& pool, std::vector<CommandList>& lists, unsigned int itemCount,
+			const std::function<void(CommandList& list, unsigned int begin, unsigned int end)>& record);
+
+		inline size_t GetSize() const { return m_Data.size(); }
+		inline unsigned int GetDrawCount() const { return m_DrawCount; }
+};
@@ -0,0 +1,131 @@
+#include "FrameClock.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <thread>
+
+// Sleeps are only trusted up to this close to the deadline, the rest is spun
+static const std::chrono::microseconds s_SpinMargin(2000);
+
+PresentMode ApplyPresentMode(PresentMode mode)
+{
+    if (mode == PresentMode::Adaptive &&
+        !glfwExtensionSupported("WGL_EXT_swap_control_tear") && !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+        mode = PresentMode::Vsync;
+
+    switch (mode) {
+        case PresentMode::Vsync:    glfwSwapInterval(1); break;
+        case PresentMode::Adaptive: glfwSwapInterval(-1); break;
+        case PresentMode::Unlocked:
+        case PresentMode::Capped:   glfwSwapInterval(0); break;
+    }
+    return mode;
+}
+
+const char* GetPresentModeName(PresentMode mode)
+{
+    switch (mode) {
+        case PresentMode::Vsync:    return "vsync";
+        case PresentMode::Adaptive: return "adaptive";
+        case PresentMode::Unlocked: return "unlocked";
+        case PresentMode::Capped:   return "capped";
+    }
+    return "unknown";
+}
+
+FrameClock::FrameClock(unsigned int historyFrames)
+    : m_LastTick(Clock::now()), m_NextDeadline(m_LastTick), m_TargetPeriod(Clock::duration::zero()), m_DeltaTime(0.0),
+    m_History(std::max(historyFrames, 1u)), m_HistoryNext(0), m_HistoryCount(0), m_Bins(BinCount, 0)
+{
+}
+
+void FrameClock::SetFrameCap(double framesPerSecond)
+{
+    if (framesPerSecond > 0.0)
+        m_TargetPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond));
+    else
+        m_TargetPeriod = Clock::duration::zero();
+    m_NextDeadline = Clock::now() + m_TargetPeriod;
+}
+
+void FrameClock::WaitForDeadline()
+{
+    Clock::time_point now = Clock::now();
+    if (m_NextDeadline - now > s_SpinMargin)
+        std::this_thread::sleep_for(m_NextDeadline - now - s_SpinMargin);
+    while (Clock::now() < m_NextDeadline)
+        std::this_thread::yield();
+
+    // Keep a steady cadence, unless we fell more than a frame behind: then start over rather than rush to catch up
+    m_NextDeadline += m_TargetPeriod;
+    now = Clock::now();
+    if (m_NextDeadline < now)
+        m_NextDeadline = now + m_TargetPeriod;
+}
+
+double FrameClock::Tick()
+{
+    if (m_TargetPeriod != Clock::duration::zero())
+        WaitForDeadline();
+
+    Clock::time_point now = Clock::now();
+    m_DeltaTime = std::chrono::duration<double>(now - m_LastTick).count();
+    m_LastTick = now;
+    Record(m_DeltaTime * 1000.0);
+    return m_DeltaTime;
+}
+
+static unsigned int BinIndex(double frameMs)
+{
+    return std::min((unsigned int)(frameMs / FrameClock::BinWidthMs), FrameClock::BinCount - 1);
+}
+
+void FrameClock::Record(double frameMs)
+{
+    // Evict the oldest sample once the window is full so the histogram only ever covers the last frames
+    if (m_HistoryCount == m_History.size())
+        m_Bins[BinIndex(m_History[m_HistoryNext])]--;
+    else
+        m_HistoryCount++;
+
+    m_History[m_HistoryNext] = (float)frameMs;
+    m_Bins[BinIndex(frameMs)]++;
+    m_HistoryNext = (m_HistoryNext + 1) % (unsigned int)m_History.size();
+}
+
+double FrameClock::GetPercentile(double p) const
+{
+    if (m_HistoryCount == 0)
+        return 0.0;
+    unsigned int rank = std::max((unsigned int)(p * m_HistoryCount + 0.5), 1u);
+    unsigned int seen = 0;
+    for (unsigned int i = 0; i < BinCount - 1; i++) {
+        seen += m_Bins[i];
+        if (seen >= rank)
+            return (i + 1) * BinWidthMs;
+    }
+    return GetMaxFrameTime();
+}
+
+std::vector<double> FrameClock::GetFrameTimes() const
+{
+    std::vector<double> frameTimes;
+    frameTimes.reserve(m_HistoryCount);
+    unsigned int first = m_HistoryCount == m_History.size() ? m_HistoryNext : 0;
+    for (unsigned int i = 0; i < m_HistoryCount; i++)
+        frameTimes.push_back(m_History[(first + i) % m_History.size()]);
+    return frameTimes;
+}
+
+double FrameClock::GetMinFrameTime() const
+{
+    if (m_HistoryCount == 0)
+        return 0.0;
+    return *std::min_element(m_History.begin(), m_History.begin() + m_HistoryCount);
+}
+
+double FrameClock::GetMaxFrameTime() const
+{
+    if (m_HistoryCount == 0)
+        return 0.0;
+    return *std::max_element(m_History.begin(), m_History.begin() + m_HistoryCount);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+enum class PresentMode
+{
+	Vsync,		// swap interval 1
+	Adaptive,	// swap interval -1, late frames tear instead of waiting a whole refresh
+	Unlocked,	// swap interval 0
+	Capped		// swap interval 0, the frame clock paces frames to a target rate
+};
+
+/**
+* Sets the swap interval of the current context for the given mode.
+* Returns the mode actually in use: Adaptive falls back to Vsync without EXT_swap_control_tear.
+**/
+PresentMode ApplyPresentMode(PresentMode mode);
+const char* GetPresentModeName(PresentMode mode);
+
+/**
+* Measures frame times, drives updates from the measured delta time and optionally caps the frame rate.
+* The last HistoryFrames frame times are kept in a histogram of BinWidthMs bins for cheap percentiles.
+**/
+class FrameClock
+{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr double BinWidthMs = 0.1;
+		static const unsigned int BinCount = 1000;	// 0 - 100ms, slower frames land in the last bin
+
+	private:
+		Clock::time_point m_LastTick;
+		Clock::time_point m_NextDeadline;
+		Clock::duration m_TargetPeriod;	// zero when uncapped
+		double m_DeltaTime;
+
+		std::vector<float> m_History;	// ring of frame times in milliseconds
+		unsigned int m_HistoryNext;
+		unsigned int m_HistoryCount;
+		std::vector<unsigned int> m_Bins;
+
+		void WaitForDeadline();
+		void Record(double frameMs);
+
+	public:
+		explicit FrameClock(unsigned int historyFrames = 512);
+
+		// Target frame rate used in PresentMode::Capped, 0 disables the cap
+		void SetFrameCap(double framesPerSecond);
+
+		/**
+		* Ends the current frame: waits for the frame cap if any, then records the frame time
+		* Returns the delta time in seconds to advance the next update by
+		**/
+		double Tick();
+
+		inline double GetDeltaTime() const { return m_DeltaTime; }
+		inline unsigned int GetSampleCount() const { return m_HistoryCount; }
+
+		// Frame time in milliseconds under which the fraction p of the recorded frames fall, bin accurate
+		double GetPercentile(double p) const;
+		// The recorded frame times in milliseconds, oldest first, for exact statistics over a whole run
+		std::vector<double> GetFrameTimes() const;
+		double GetMinFrameTime() const;
+		double GetMaxFrameTime() const;
+};
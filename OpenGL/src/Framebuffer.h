@@ -0,0 +1,27 @@
+#pragma once
+
+/**
+* Offscreen render target: an RGBA8 color renderbuffer attached to a framebuffer object
+**/
+class Framebuffer
+{
+	private:
+		unsigned int m_RendererID;
+		unsigned int m_ColorAttachment;
+		int m_Width;
+		int m_Height;
+
+	public:
+		Framebuffer(int width, int height);
+		~Framebuffer();
+
+		Framebuffer(const Framebuffer&) = delete;
+		Framebuffer& operator=(const Framebuffer&) = delete;
+
+		// Binds for drawing and sets the viewport to cover the whole target
+		void Bind() const;
+		void Unbind() const;
+
+		inline int GetWidth() const { return m_Width; }
+		inline int GetHeight() const { return m_Height; }
+};
@@ -0,0 +1,43 @@
+#include "GLCaps.h"
+#include <GL/glew.h>
+
+static GLCaps s_Supported = {};
+static GLCaps s_Enabled = {};
+
+const GLCaps& GLCaps::Get()
+{
+    return s_Enabled;
+}
+
+#ifndef GL_DISPATCH_NULL_ONLY
+void GLCaps::Detect()
+{
+    s_Supported.directStateAccess = GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access;
+    s_Supported.vertexAttribBinding = GLEW_VERSION_4_3 || GLEW_ARB_vertex_attrib_binding;
+    s_Supported.shaderStorageBuffer = GLEW_VERSION_4_3 || GLEW_ARB_shader_storage_buffer_object;
+    s_Enabled = s_Supported;
+}
+#endif
+
+void GLCaps::EnableAll()
+{
+    s_Supported.directStateAccess = true;
+    s_Supported.vertexAttribBinding = true;
+    s_Supported.shaderStorageBuffer = true;
+    s_Enabled = s_Supported;
+}
+
+void GLCaps::SetDirectStateAccess(bool enabled)
+{
+    s_Enabled.directStateAccess = enabled && s_Supported.directStateAccess;
+}
+
+void GLCaps::SetVertexAttribBinding(bool enabled)
+{
+    s_Enabled.vertexAttribBinding = enabled && s_Supported.vertexAttribBinding;
+}
+
+void GLCaps::SetShaderStorageBuffer(bool enabled)
+{
+    s_Enabled.shaderStorageBuffer = enabled && s_Supported.shaderStorageBuffer;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+* Optional GL features the engine has a faster path for, filled in by GLDispatchLoadDriver/GLDispatchLoadNull.
+* Each one can be switched off to run and measure the fallback, features the context lacks can't be switched on.
+**/
+struct GLCaps
+{
+	bool directStateAccess;		// GL 4.5 or ARB_direct_state_access: objects are created and edited without binding them
+	bool vertexAttribBinding;	// GL 4.3 or ARB_vertex_attrib_binding: attribute formats are set apart from the buffers they read
+	bool shaderStorageBuffer;	// GL 4.3 or ARB_shader_storage_buffer_object: shaders index buffers directly
+
+	static const GLCaps& Get();
+
+#ifndef GL_DISPATCH_NULL_ONLY
+	// Reads the current context's version and extensions through GLEW
+	static void Detect();
+#endif
+	// The null backend accepts every entry point
+	static void EnableAll();
+
+	static void SetDirectStateAccess(bool enabled);
+	static void SetVertexAttribBinding(bool enabled);
+	static void SetShaderStorageBuffer(bool enabled);
+};
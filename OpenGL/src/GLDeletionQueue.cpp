@@ -0,0 +1,80 @@
+#include "GLDeletionQueue.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+
+GLDeletionQueue::GLDeletionQueue()
+{
+    m_Current.fence = nullptr;
+}
+
+GLDeletionQueue& GLDeletionQueue::Get()
+{
+    static thread_local GLDeletionQueue queue;
+    return queue;
+}
+
+void GLDeletionQueue::DeleteNames(Batch& batch)
+{
+    GLStateCache& state = GLStateCache::Get();
+    if (!batch.buffers.empty()) {
+        GLCall(glDeleteBuffers((GLsizei)batch.buffers.size(), batch.buffers.data()));
+        for (unsigned int buffer : batch.buffers)
+            state.OnDeleteBuffer(buffer);
+    }
+    if (!batch.vertexArrays.empty()) {
+        GLCall(glDeleteVertexArrays((GLsizei)batch.vertexArrays.size(), batch.vertexArrays.data()));
+        for (unsigned int vertexArray : batch.vertexArrays)
+            state.OnDeleteVertexArray(vertexArray);
+    }
+    if (batch.fence) {
+        GLCall(glDeleteSync(batch.fence));
+    }
+}
+
+void GLDeletionQueue::DeleteBuffer(unsigned int buffer)
+{
+    m_Current.buffers.push_back(buffer);
+}
+
+void GLDeletionQueue::DeleteVertexArray(unsigned int vertexArray)
+{
+    m_Current.vertexArrays.push_back(vertexArray);
+}
+
+void GLDeletionQueue::EndFrame()
+{
+    if (!m_Current.buffers.empty() || !m_Current.vertexArrays.empty()) {
+        GLCall(m_Current.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        m_Retiring.push_back(std::move(m_Current));
+        m_Current = Batch();
+        m_Current.fence = nullptr;
+    }
+
+    // Fences signal in submission order, stop at the first one still pending
+    while (!m_Retiring.empty()) {
+        GLenum status;
+        GLCall(status = glClientWaitSync(m_Retiring.front().fence, 0, 0));
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            break;
+        DeleteNames(m_Retiring.front());
+        m_Retiring.pop_front();
+    }
+}
+
+void GLDeletionQueue::Flush()
+{
+    for (Batch& batch : m_Retiring)
+        DeleteNames(batch);
+    m_Retiring.clear();
+    DeleteNames(m_Current);
+    m_Current = Batch();
+    m_Current.fence = nullptr;
+}
+
+unsigned int GLDeletionQueue::GetPendingCount() const
+{
+    size_t count = m_Current.buffers.size() + m_Current.vertexArrays.size();
+    for (const Batch& batch : m_Retiring)
+        count += batch.buffers.size() + batch.vertexArrays.size();
+    return (unsigned int)count;
+}
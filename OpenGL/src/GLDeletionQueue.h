@@ -0,0 +1,45 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+struct __GLsync;
+
+/**
+* Defers glDelete* calls until the GPU has retired every frame that could still use the objects.
+* Names queued during a frame are fenced together at EndFrame and deleted once that fence has signalled,
+* so destroying a resource never makes the driver wait on in-flight work.
+* Like the state cache there is one queue per thread, for the context current on it.
+**/
+class GLDeletionQueue
+{
+	private:
+		struct Batch
+		{
+			std::vector<unsigned int> buffers;
+			std::vector<unsigned int> vertexArrays;
+			__GLsync* fence;
+		};
+
+		Batch m_Current;
+		std::deque<Batch> m_Retiring;	// oldest first, each waiting on its fence
+
+		static void DeleteNames(Batch& batch);
+
+	public:
+		GLDeletionQueue();
+
+		static GLDeletionQueue& Get();
+
+		void DeleteBuffer(unsigned int buffer);
+		void DeleteVertexArray(unsigned int vertexArray);
+
+		// Fences the names queued this frame and deletes the batches the GPU is done with, never waits
+		void EndFrame();
+
+		// Deletes everything right away, call before the context goes away
+		void Flush();
+
+		// Names queued but not deleted yet
+		unsigned int GetPendingCount() const;
+};
@@ -0,0 +1,187 @@
+#define GL_DISPATCH_NO_REDIRECT
+#include "GLDispatch.h"
+#include "GLCaps.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+GLDispatchTable g_GLDispatch = {};
+
+// Implementation the recording thunks forward to
+static GLDispatchTable s_Target = {};
+static bool s_Recording = false;
+// Relaxed atomics: UploadService's worker issues GL calls through the same table as the render thread
+static std::atomic<unsigned int> s_CallCounts[(unsigned int)GLFunction::Count] = {};
+
+static const char* s_FunctionNames[] = {
+#define GL_DISPATCH_NAME(ret, name, params, args) "gl" #name,
+    GL_DISPATCH_FUNCTIONS(GL_DISPATCH_NAME)
+#undef GL_DISPATCH_NAME
+};
+
+/**
+* Null implementation: every entry point returns a zeroed value, the few the wrappers rely on are overridden below
+**/
+template<typename T>
+static T NullResult() { return T(); }
+
+#define GL_DISPATCH_NULL(ret, name, params, args) static ret GLAPIENTRY NullDefault##name params { return NullResult<ret>(); }
+GL_DISPATCH_FUNCTIONS(GL_DISPATCH_NULL)
+#undef GL_DISPATCH_NULL
+
+// Names are never reused so a deleted object can't alias a new one in caches keyed by name
+static GLuint s_NextName = 1;
+
+static void GLAPIENTRY NullGenNames(GLsizei n, GLuint* names) {
+    for (GLsizei i = 0; i < n; i++)
+        names[i] = s_NextName++;
+}
+
+static GLuint GLAPIENTRY NullCreateProgram() {
+    return s_NextName++;
+}
+
+static GLuint GLAPIENTRY NullCreateShader(GLenum type) {
+    return s_NextName++;
+}
+
+static void GLAPIENTRY NullGetShaderiv(GLuint shader, GLenum pname, GLint* param) {
+    // Every shader compiles, with an empty info log
+    *param = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void GLAPIENTRY NullGetProgramiv(GLuint program, GLenum pname, GLint* param) {
+    *param = (pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS) ? GL_TRUE : 0;
+}
+
+static void GLAPIENTRY NullGetIntegerv(GLenum pname, GLint* params) {
+    *params = 0;
+}
+
+static void GLAPIENTRY NullGetInteger64v(GLenum pname, GLint64* params) {
+    *params = 0;
+}
+
+static void GLAPIENTRY NullGetQueryObjectiv(GLuint id, GLenum pname, GLint* params) {
+    // Results are always available so nothing waits on a GPU that isn't there
+    *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+static void GLAPIENTRY NullGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params) {
+    *params = 0;
+}
+
+static GLenum GLAPIENTRY NullCheckFramebufferStatus(GLenum target) {
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static GLsync GLAPIENTRY NullFenceSync(GLenum condition, GLbitfield flags) {
+    // Any non-null handle will do, nothing ever waits on it
+    return (GLsync)(uintptr_t)s_NextName++;
+}
+
+static GLenum GLAPIENTRY NullClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    return GL_ALREADY_SIGNALED;
+}
+
+// Mapped ranges point into scratch memory, writes land somewhere harmless and are dropped
+static std::vector<unsigned char> s_MapScratch;
+
+static void* GLAPIENTRY NullMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    if (s_MapScratch.size() < (size_t)length)
+        s_MapScratch.resize((size_t)length);
+    return s_MapScratch.data();
+}
+
+static GLboolean GLAPIENTRY NullUnmapBuffer(GLenum target) {
+    return GL_TRUE;
+}
+
+static const GLubyte* GLAPIENTRY NullGetString(GLenum name) {
+    return (const GLubyte*)"Null GL";
+}
+
+#define GL_DISPATCH_RECORD(ret, name, params, args) static ret GLAPIENTRY Record##name params {\
+    s_CallCounts[(unsigned int)GLFunction::name].fetch_add(1, std::memory_order_relaxed);\
+    return s_Target.name args;\
+}
+GL_DISPATCH_FUNCTIONS(GL_DISPATCH_RECORD)
+#undef GL_DISPATCH_RECORD
+
+static void ApplyTarget() {
+    if (s_Recording) {
+#define GL_DISPATCH_SET_RECORD(ret, name, params, args) g_GLDispatch.name = Record##name;
+        GL_DISPATCH_FUNCTIONS(GL_DISPATCH_SET_RECORD)
+#undef GL_DISPATCH_SET_RECORD
+    }
+    else {
+        g_GLDispatch = s_Target;
+    }
+}
+
+#ifndef GL_DISPATCH_NULL_ONLY
+void GLDispatchLoadDriver() {
+    // Core 1.1 functions are exported by the GL library, the rest are GLEW's function pointers
+#define GL_DISPATCH_SET_DRIVER(ret, name, params, args) s_Target.name = gl##name;
+    GL_DISPATCH_FUNCTIONS(GL_DISPATCH_SET_DRIVER)
+#undef GL_DISPATCH_SET_DRIVER
+    ApplyTarget();
+    GLCaps::Detect();
+}
+#endif
+
+void GLDispatchLoadNull() {
+#define GL_DISPATCH_SET_NULL(ret, name, params, args) s_Target.name = NullDefault##name;
+    GL_DISPATCH_FUNCTIONS(GL_DISPATCH_SET_NULL)
+#undef GL_DISPATCH_SET_NULL
+
+    s_Target.GenBuffers = NullGenNames;
+    s_Target.GenFramebuffers = NullGenNames;
+    s_Target.GenQueries = NullGenNames;
+    s_Target.GenRenderbuffers = NullGenNames;
+    s_Target.GenTextures = NullGenNames;
+    s_Target.GenVertexArrays = NullGenNames;
+    s_Target.CreateBuffers = NullGenNames;
+    s_Target.CreateVertexArrays = NullGenNames;
+    s_Target.CreateProgram = NullCreateProgram;
+    s_Target.CreateShader = NullCreateShader;
+    s_Target.GetShaderiv = NullGetShaderiv;
+    s_Target.GetProgramiv = NullGetProgramiv;
+    s_Target.GetIntegerv = NullGetIntegerv;
+    s_Target.GetInteger64v = NullGetInteger64v;
+    s_Target.GetQueryObjectiv = NullGetQueryObjectiv;
+    s_Target.GetQueryObjectui64v = NullGetQueryObjectui64v;
+    s_Target.GetString = NullGetString;
+    s_Target.CheckFramebufferStatus = NullCheckFramebufferStatus;
+    s_Target.FenceSync = NullFenceSync;
+    s_Target.ClientWaitSync = NullClientWaitSync;
+    s_Target.MapBufferRange = NullMapBufferRange;
+    s_Target.UnmapBuffer = NullUnmapBuffer;
+    ApplyTarget();
+    GLCaps::EnableAll();
+}
+
+void GLDispatchSetRecording(bool enabled) {
+    s_Recording = enabled;
+    ApplyTarget();
+}
+
+unsigned int GLDispatchGetCallCount(GLFunction function) {
+    return s_CallCounts[(unsigned int)function].load(std::memory_order_relaxed);
+}
+
+unsigned int GLDispatchGetTotalCallCount() {
+    unsigned int total = 0;
+    for (const std::atomic<unsigned int>& count : s_CallCounts)
+        total += count.load(std::memory_order_relaxed);
+    return total;
+}
+
+void GLDispatchResetCallCounts() {
+    for (std::atomic<unsigned int>& count : s_CallCounts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+const char* GLDispatchGetFunctionName(GLFunction function) {
+    return s_FunctionNames[(unsigned int)function];
+}
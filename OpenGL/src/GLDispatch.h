@@ -0,0 +1,339 @@
+#pragma once
+
+#include <GL/glew.h>
+
+/**
+* Every GL entry point the engine uses, X(return type, name without "gl", parameters, arguments).
+* Adding a GL call to the engine means adding its entry point here.
+**/
+#define GL_DISPATCH_FUNCTIONS(X) \
+	X(void, ActiveTexture, (GLenum texture), (texture)) \
+	X(void, AttachShader, (GLuint program, GLuint shader), (program, shader)) \
+	X(void, BeginQuery, (GLenum target, GLuint id), (target, id)) \
+	X(void, BindBuffer, (GLenum target, GLuint buffer), (target, buffer)) \
+	X(void, BindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer)) \
+	X(void, BindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer)) \
+	X(void, BindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer)) \
+	X(void, BindTexture, (GLenum target, GLuint texture), (target, texture)) \
+	X(void, BindVertexArray, (GLuint array), (array)) \
+	X(void, BindVertexBuffer, (GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride), (bindingindex, buffer, offset, stride)) \
+	X(void, BufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage)) \
+	X(void, BufferStorage, (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags), (target, size, data, flags)) \
+	X(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data)) \
+	X(GLenum, CheckFramebufferStatus, (GLenum target), (target)) \
+	X(void, Clear, (GLbitfield mask), (mask)) \
+	X(GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout)) \
+	X(void, CompileShader, (GLuint shader), (shader)) \
+	X(void, CopyBufferSubData, (GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size), (readTarget, writeTarget, readOffset, writeOffset, size)) \
+	X(void, CreateBuffers, (GLsizei n, GLuint* buffers), (n, buffers)) \
+	X(GLuint, CreateProgram, (void), ()) \
+	X(GLuint, CreateShader, (GLenum type), (type)) \
+	X(void, CreateVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays)) \
+	X(void, DebugMessageCallback, (GLDEBUGPROC callback, const void* userParam), (callback, userParam)) \
+	X(void, DeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers)) \
+	X(void, DeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), (n, framebuffers)) \
+	X(void, DeleteProgram, (GLuint program), (program)) \
+	X(void, DeleteQueries, (GLsizei n, const GLuint* ids), (n, ids)) \
+	X(void, DeleteRenderbuffers, (GLsizei n, const GLuint* renderbuffers), (n, renderbuffers)) \
+	X(void, DeleteShader, (GLuint shader), (shader)) \
+	X(void, DeleteSync, (GLsync sync), (sync)) \
+	X(void, DeleteTextures, (GLsizei n, const GLuint* textures), (n, textures)) \
+	X(void, DeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays)) \
+	X(void, DetachShader, (GLuint program, GLuint shader), (program, shader)) \
+	X(void, Disable, (GLenum cap), (cap)) \
+	X(void, DisableVertexArrayAttrib, (GLuint vaobj, GLuint index), (vaobj, index)) \
+	X(void, DisableVertexAttribArray, (GLuint index), (index)) \
+	X(void, DrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+	X(void, DrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices)) \
+	X(void, DrawElementsBaseVertex, (GLenum mode, GLsizei count, GLenum type, void* indices, GLint baseVertex), (mode, count, type, indices, baseVertex)) \
+	X(void, DrawElementsInstancedBaseVertex, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei primcount, GLint basevertex), (mode, count, type, indices, primcount, basevertex)) \
+	X(void, Enable, (GLenum cap), (cap)) \
+	X(void, EnableVertexArrayAttrib, (GLuint vaobj, GLuint index), (vaobj, index)) \
+	X(void, EnableVertexAttribArray, (GLuint index), (index)) \
+	X(void, EndQuery, (GLenum target), (target)) \
+	X(GLsync, FenceSync, (GLenum condition, GLbitfield flags), (condition, flags)) \
+	X(void, Finish, (void), ()) \
+	X(void, Flush, (void), ()) \
+	X(void, FramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer)) \
+	X(void, GenBuffers, (GLsizei n, GLuint* buffers), (n, buffers)) \
+	X(void, GenFramebuffers, (GLsizei n, GLuint* framebuffers), (n, framebuffers)) \
+	X(void, GenQueries, (GLsizei n, GLuint* ids), (n, ids)) \
+	X(void, GenRenderbuffers, (GLsizei n, GLuint* renderbuffers), (n, renderbuffers)) \
+	X(void, GenTextures, (GLsizei n, GLuint* textures), (n, textures)) \
+	X(void, GenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays)) \
+	X(GLenum, GetError, (void), ()) \
+	X(void, GetInteger64v, (GLenum pname, GLint64* params), (pname, params)) \
+	X(void, GetIntegerv, (GLenum pname, GLint* params), (pname, params)) \
+	X(void, GetProgramiv, (GLuint program, GLenum pname, GLint* param), (program, pname, param)) \
+	X(void, GetQueryObjectiv, (GLuint id, GLenum pname, GLint* params), (id, pname, params)) \
+	X(void, GetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64* params), (id, pname, params)) \
+	X(void, GetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (shader, bufSize, length, infoLog)) \
+	X(void, GetShaderiv, (GLuint shader, GLenum pname, GLint* param), (shader, pname, param)) \
+	X(const GLubyte*, GetString, (GLenum name), (name)) \
+	X(GLint, GetUniformLocation, (GLuint program, const GLchar* name), (program, name)) \
+	X(void, LinkProgram, (GLuint program), (program)) \
+	X(void*, MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access)) \
+	X(void, NamedBufferData, (GLuint buffer, GLsizeiptr size, const void* data, GLenum usage), (buffer, size, data, usage)) \
+	X(void, NamedBufferStorage, (GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags), (buffer, size, data, flags)) \
+	X(void, NamedBufferSubData, (GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data), (buffer, offset, size, data)) \
+	X(void, PrimitiveRestartIndex, (GLuint index), (index)) \
+	X(void, QueryCounter, (GLuint id, GLenum target), (id, target)) \
+	X(void, RenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height)) \
+	X(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length), (shader, count, string, length)) \
+	X(void, TexBuffer, (GLenum target, GLenum internalformat, GLuint buffer), (target, internalformat, buffer)) \
+	X(void, Uniform1f, (GLint location, GLfloat v0), (location, v0)) \
+	X(void, Uniform1i, (GLint location, GLint v0), (location, v0)) \
+	X(void, Uniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3)) \
+	X(void, Uniform4fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value)) \
+	X(GLboolean, UnmapBuffer, (GLenum target), (target)) \
+	X(void, UseProgram, (GLuint program), (program)) \
+	X(void, ValidateProgram, (GLuint program), (program)) \
+	X(void, VertexArrayAttribBinding, (GLuint vaobj, GLuint attribindex, GLuint bindingindex), (vaobj, attribindex, bindingindex)) \
+	X(void, VertexArrayAttribFormat, (GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset), (vaobj, attribindex, size, type, normalized, relativeoffset)) \
+	X(void, VertexArrayBindingDivisor, (GLuint vaobj, GLuint bindingindex, GLuint divisor), (vaobj, bindingindex, divisor)) \
+	X(void, VertexArrayElementBuffer, (GLuint vaobj, GLuint buffer), (vaobj, buffer)) \
+	X(void, VertexArrayVertexBuffer, (GLuint vaobj, GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride), (vaobj, bindingindex, buffer, offset, stride)) \
+	X(void, VertexAttribBinding, (GLuint attribindex, GLuint bindingindex), (attribindex, bindingindex)) \
+	X(void, VertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor)) \
+	X(void, VertexAttribFormat, (GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset), (attribindex, size, type, normalized, relativeoffset)) \
+	X(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer), (index, size, type, normalized, stride, pointer)) \
+	X(void, VertexBindingDivisor, (GLuint bindingindex, GLuint divisor), (bindingindex, divisor)) \
+	X(void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
+
+/**
+* Table the engine calls GL through. It points either at the driver (through GLEW) or at a no-op
+* implementation that needs neither a driver nor a context, for headless benchmarks and CI.
+**/
+struct GLDispatchTable
+{
+#define GL_DISPATCH_MEMBER(ret, name, params, args) ret (GLAPIENTRY* name) params;
+	GL_DISPATCH_FUNCTIONS(GL_DISPATCH_MEMBER)
+#undef GL_DISPATCH_MEMBER
+};
+
+enum class GLFunction : unsigned int
+{
+#define GL_DISPATCH_ENUM(ret, name, params, args) name,
+	GL_DISPATCH_FUNCTIONS(GL_DISPATCH_ENUM)
+#undef GL_DISPATCH_ENUM
+	Count
+};
+
+extern GLDispatchTable g_GLDispatch;
+
+/**
+* Points the table at the driver and detects GLCaps, call after glewInit
+* Builds defining GL_DISPATCH_NULL_ONLY link neither GLEW nor a GL library and only have the null table
+**/
+#ifndef GL_DISPATCH_NULL_ONLY
+void GLDispatchLoadDriver();
+#endif
+
+/**
+* Points the table at stubs that only hand out object names and report success.
+* No context is needed, nothing is drawn. Every GLCaps feature reports as supported.
+**/
+void GLDispatchLoadNull();
+
+/**
+* Routes every call through a counter before the loaded implementation (driver or null).
+* Counters are atomic and count the calls of every thread, UploadService's worker included.
+* Switching rewrites the shared table: only toggle while no other thread issues GL calls.
+**/
+void GLDispatchSetRecording(bool enabled);
+
+unsigned int GLDispatchGetCallCount(GLFunction function);
+unsigned int GLDispatchGetTotalCallCount();
+void GLDispatchResetCallCounts();
+const char* GLDispatchGetFunctionName(GLFunction function);
+
+/**
+* From here on gl* calls resolve to the table instead of GLEW. GLCall's #x still reads "glBufferData(...)".
+* GLDispatch.cpp defines GL_DISPATCH_NO_REDIRECT to reach the real entry points.
+**/
+#ifndef GL_DISPATCH_NO_REDIRECT
+#undef glActiveTexture
+#define glActiveTexture g_GLDispatch.ActiveTexture
+#undef glAttachShader
+#define glAttachShader g_GLDispatch.AttachShader
+#undef glBeginQuery
+#define glBeginQuery g_GLDispatch.BeginQuery
+#undef glBindBuffer
+#define glBindBuffer g_GLDispatch.BindBuffer
+#undef glBindBufferBase
+#define glBindBufferBase g_GLDispatch.BindBufferBase
+#undef glBindFramebuffer
+#define glBindFramebuffer g_GLDispatch.BindFramebuffer
+#undef glBindRenderbuffer
+#define glBindRenderbuffer g_GLDispatch.BindRenderbuffer
+#undef glBindTexture
+#define glBindTexture g_GLDispatch.BindTexture
+#undef glBindVertexArray
+#define glBindVertexArray g_GLDispatch.BindVertexArray
+#undef glBindVertexBuffer
+#define glBindVertexBuffer g_GLDispatch.BindVertexBuffer
+#undef glBufferData
+#define glBufferData g_GLDispatch.BufferData
+#undef glBufferStorage
+#define glBufferStorage g_GLDispatch.BufferStorage
+#undef glBufferSubData
+#define glBufferSubData g_GLDispatch.BufferSubData
+#undef glCheckFramebufferStatus
+#define glCheckFramebufferStatus g_GLDispatch.CheckFramebufferStatus
+#undef glClear
+#define glClear g_GLDispatch.Clear
+#undef glClientWaitSync
+#define glClientWaitSync g_GLDispatch.ClientWaitSync
+#undef glCompileShader
+#define glCompileShader g_GLDispatch.CompileShader
+#undef glCopyBufferSubData
+#define glCopyBufferSubData g_GLDispatch.CopyBufferSubData
+#undef glCreateBuffers
+#define glCreateBuffers g_GLDispatch.CreateBuffers
+#undef glCreateProgram
+#define glCreateProgram g_GLDispatch.CreateProgram
+#undef glCreateShader
+#define glCreateShader g_GLDispatch.CreateShader
+#undef glCreateVertexArrays
+#define glCreateVertexArrays g_GLDispatch.CreateVertexArrays
+#undef glDebugMessageCallback
+#define glDebugMessageCallback g_GLDispatch.DebugMessageCallback
+#undef glDeleteBuffers
+#define glDeleteBuffers g_GLDispatch.DeleteBuffers
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers g_GLDispatch.DeleteFramebuffers
+#undef glDeleteProgram
+#define glDeleteProgram g_GLDispatch.DeleteProgram
+#undef glDeleteQueries
+#define glDeleteQueries g_GLDispatch.DeleteQueries
+#undef glDeleteRenderbuffers
+#define glDeleteRenderbuffers g_GLDispatch.DeleteRenderbuffers
+#undef glDeleteShader
+#define glDeleteShader g_GLDispatch.DeleteShader
+#undef glDeleteSync
+#define glDeleteSync g_GLDispatch.DeleteSync
+#undef glDeleteTextures
+#define glDeleteTextures g_GLDispatch.DeleteTextures
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays g_GLDispatch.DeleteVertexArrays
+#undef glDetachShader
+#define glDetachShader g_GLDispatch.DetachShader
+#undef glDisable
+#define glDisable g_GLDispatch.Disable
+#undef glDisableVertexArrayAttrib
+#define glDisableVertexArrayAttrib g_GLDispatch.DisableVertexArrayAttrib
+#undef glDisableVertexAttribArray
+#define glDisableVertexAttribArray g_GLDispatch.DisableVertexAttribArray
+#undef glDrawArrays
+#define glDrawArrays g_GLDispatch.DrawArrays
+#undef glDrawElements
+#define glDrawElements g_GLDispatch.DrawElements
+#undef glDrawElementsBaseVertex
+#define glDrawElementsBaseVertex g_GLDispatch.DrawElementsBaseVertex
+#undef glDrawElementsInstancedBaseVertex
+#define glDrawElementsInstancedBaseVertex g_GLDispatch.DrawElementsInstancedBaseVertex
+#undef glEnable
+#define glEnable g_GLDispatch.Enable
+#undef glEnableVertexArrayAttrib
+#define glEnableVertexArrayAttrib g_GLDispatch.EnableVertexArrayAttrib
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray g_GLDispatch.EnableVertexAttribArray
+#undef glEndQuery
+#define glEndQuery g_GLDispatch.EndQuery
+#undef glFenceSync
+#define glFenceSync g_GLDispatch.FenceSync
+#undef glFinish
+#define glFinish g_GLDispatch.Finish
+#undef glFlush
+#define glFlush g_GLDispatch.Flush
+#undef glFramebufferRenderbuffer
+#define glFramebufferRenderbuffer g_GLDispatch.FramebufferRenderbuffer
+#undef glGenBuffers
+#define glGenBuffers g_GLDispatch.GenBuffers
+#undef glGenFramebuffers
+#define glGenFramebuffers g_GLDispatch.GenFramebuffers
+#undef glGenQueries
+#define glGenQueries g_GLDispatch.GenQueries
+#undef glGenRenderbuffers
+#define glGenRenderbuffers g_GLDispatch.GenRenderbuffers
+#undef glGenTextures
+#define glGenTextures g_GLDispatch.GenTextures
+#undef glGenVertexArrays
+#define glGenVertexArrays g_GLDispatch.GenVertexArrays
+#undef glGetError
+#define glGetError g_GLDispatch.GetError
+#undef glGetInteger64v
+#define glGetInteger64v g_GLDispatch.GetInteger64v
+#undef glGetIntegerv
+#define glGetIntegerv g_GLDispatch.GetIntegerv
+#undef glGetProgramiv
+#define glGetProgramiv g_GLDispatch.GetProgramiv
+#undef glGetQueryObjectiv
+#define glGetQueryObjectiv g_GLDispatch.GetQueryObjectiv
+#undef glGetQueryObjectui64v
+#define glGetQueryObjectui64v g_GLDispatch.GetQueryObjectui64v
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog g_GLDispatch.GetShaderInfoLog
+#undef glGetShaderiv
+#define glGetShaderiv g_GLDispatch.GetShaderiv
+#undef glGetString
+#define glGetString g_GLDispatch.GetString
+#undef glGetUniformLocation
+#define glGetUniformLocation g_GLDispatch.GetUniformLocation
+#undef glLinkProgram
+#define glLinkProgram g_GLDispatch.LinkProgram
+#undef glMapBufferRange
+#define glMapBufferRange g_GLDispatch.MapBufferRange
+#undef glNamedBufferData
+#define glNamedBufferData g_GLDispatch.NamedBufferData
+#undef glNamedBufferStorage
+#define glNamedBufferStorage g_GLDispatch.NamedBufferStorage
+#undef glNamedBufferSubData
+#define glNamedBufferSubData g_GLDispatch.NamedBufferSubData
+#undef glPrimitiveRestartIndex
+#define glPrimitiveRestartIndex g_GLDispatch.PrimitiveRestartIndex
+#undef glQueryCounter
+#define glQueryCounter g_GLDispatch.QueryCounter
+#undef glRenderbufferStorage
+#define glRenderbufferStorage g_GLDispatch.RenderbufferStorage
+#undef glShaderSource
+#define glShaderSource g_GLDispatch.ShaderSource
+#undef glTexBuffer
+#define glTexBuffer g_GLDispatch.TexBuffer
+#undef glUniform1f
+#define glUniform1f g_GLDispatch.Uniform1f
+#undef glUniform1i
+#define glUniform1i g_GLDispatch.Uniform1i
+#undef glUniform4f
+#define glUniform4f g_GLDispatch.Uniform4f
+#undef glUniform4fv
+#define glUniform4fv g_GLDispatch.Uniform4fv
+#undef glUnmapBuffer
+#define glUnmapBuffer g_GLDispatch.UnmapBuffer
+#undef glUseProgram
+#define glUseProgram g_GLDispatch.UseProgram
+#undef glValidateProgram
+#define glValidateProgram g_GLDispatch.ValidateProgram
+#undef glVertexArrayAttribBinding
+#define glVertexArrayAttribBinding g_GLDispatch.VertexArrayAttribBinding
+#undef glVertexArrayAttribFormat
+#define glVertexArrayAttribFormat g_GLDispatch.VertexArrayAttribFormat
+#undef glVertexArrayBindingDivisor
+#define glVertexArrayBindingDivisor g_GLDispatch.VertexArrayBindingDivisor
+#undef glVertexArrayElementBuffer
+#define glVertexArrayElementBuffer g_GLDispatch.VertexArrayElementBuffer
+#undef glVertexArrayVertexBuffer
+#define glVertexArrayVertexBuffer g_GLDispatch.VertexArrayVertexBuffer
+#undef glVertexAttribBinding
+#define glVertexAttribBinding g_GLDispatch.VertexAttribBinding
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor g_GLDispatch.VertexAttribDivisor
+#undef glVertexAttribFormat
+#define glVertexAttribFormat g_GLDispatch.VertexAttribFormat
+#undef glVertexAttribPointer
+#define glVertexAttribPointer g_GLDispatch.VertexAttribPointer
+#undef glVertexBindingDivisor
+#define glVertexBindingDivisor g_GLDispatch.VertexBindingDivisor
+#undef glViewport
+#define glViewport g_GLDispatch.Viewport
+#endif
@@ -0,0 +1,113 @@
+#include "GLProfiler.h"
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <mutex>
+
+std::vector<std::unique_ptr<GLProfiler::ThreadCounters>> GLProfiler::s_Threads;
+thread_local GLProfiler::ThreadCounters* GLProfiler::t_Counters = nullptr;
+thread_local std::chrono::steady_clock::time_point GLProfiler::t_CallStart;
+
+// Registration and aggregation state, the per-call path never touches it
+static std::mutex s_Mutex;
+static std::vector<std::string> s_SiteNames;
+static std::vector<uint64_t> s_LastCalls(GLProfiler::MaxSites, 0);
+static std::vector<uint64_t> s_LastNanoseconds(GLProfiler::MaxSites, 0);
+static std::vector<GLProfiler::Entry> s_FrameEntries;
+
+/**
+* Pulls the called function out of a GLCall expression: the first identifier directly followed by '('
+* "int location = glGetUniformLocation(shader, \"u_Color\")" -> "glGetUniformLocation"
+**/
+static std::string ExtractFunctionName(const char* expression)
+{
+    std::string text(expression);
+    size_t paren = text.find('(');
+    if (paren == std::string::npos)
+        return text;
+    size_t end = paren;
+    while (end > 0 && isspace((unsigned char)text[end - 1]))
+        end--;
+    size_t begin = end;
+    while (begin > 0 && (isalnum((unsigned char)text[begin - 1]) || text[begin - 1] == '_'))
+        begin--;
+    return text.substr(begin, end - begin);
+}
+
+unsigned int GLProfiler::RegisterSite(const char* expression)
+{
+    std::string name = ExtractFunctionName(expression);
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    for (unsigned int i = 0; i < s_SiteNames.size(); i++)
+        if (s_SiteNames[i] == name)
+            return i;
+
+    // Out of slots, fold everything else into the last one
+    if (s_SiteNames.size() == MaxSites - 1)
+        s_SiteNames.push_back("(other)");
+    if (s_SiteNames.size() >= MaxSites)
+        return MaxSites - 1;
+
+    s_SiteNames.push_back(name);
+    return (unsigned int)s_SiteNames.size() - 1;
+}
+
+GLProfiler::ThreadCounters* GLProfiler::RegisterThread()
+{
+    std::unique_ptr<ThreadCounters> counters(new ThreadCounters());
+    for (Counter& counter : counters->counters) {
+        counter.calls.store(0, std::memory_order_relaxed);
+        counter.nanoseconds.store(0, std::memory_order_relaxed);
+    }
+    t_Counters = counters.get();
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Threads.push_back(std::move(counters));
+    return t_Counters;
+}
+
+void GLProfiler::EndFrame()
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_FrameEntries.clear();
+    for (unsigned int site = 0; site < s_SiteNames.size(); site++) {
+        uint64_t calls = 0;
+        uint64_t nanoseconds = 0;
+        for (const auto& thread : s_Threads) {
+            calls += thread->counters[site].calls.load(std::memory_order_relaxed);
+            nanoseconds += thread->counters[site].nanoseconds.load(std::memory_order_relaxed);
+        }
+
+        uint64_t frameCalls = calls - s_LastCalls[site];
+        uint64_t frameNanoseconds = nanoseconds - s_LastNanoseconds[site];
+        s_LastCalls[site] = calls;
+        s_LastNanoseconds[site] = nanoseconds;
+
+        if (frameCalls > 0)
+            s_FrameEntries.push_back({ s_SiteNames[site], frameCalls, frameNanoseconds });
+    }
+
+    std::sort(s_FrameEntries.begin(), s_FrameEntries.end(), [](const Entry& a, const Entry& b) {
+        return a.nanoseconds > b.nanoseconds;
+    });
+}
+
+const std::vector<GLProfiler::Entry>& GLProfiler::GetFrameEntries()
+{
+    return s_FrameEntries;
+}
+
+void GLProfiler::Print(std::ostream& stream)
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    std::ios_base::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    for (const Entry& entry : s_FrameEntries) {
+        stream << "  " << std::left << std::setw(28) << entry.function << " : "
+            << entry.calls << (entry.calls == 1 ? " call, " : " calls, ")
+            << std::fixed << std::setprecision(1) << entry.nanoseconds / 1000.0 << "us" << std::endl;
+    }
+    stream.flags(flags);
+    stream.precision(precision);
+}
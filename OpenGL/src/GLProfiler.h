@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+* Per GL entry point call counts and CPU time, fed by GLCall when GL_PROFILE_CALLS is 1.
+* Each thread owns its counters (single writer, no locks), EndFrame sums them into a per-frame table.
+**/
+class GLProfiler
+{
+	public:
+		static const unsigned int MaxSites = 512;
+
+		struct Entry
+		{
+			std::string function;
+			uint64_t calls;
+			uint64_t nanoseconds;
+		};
+
+	private:
+		struct Counter
+		{
+			std::atomic<uint64_t> calls;
+			std::atomic<uint64_t> nanoseconds;
+		};
+
+		struct ThreadCounters
+		{
+			Counter counters[MaxSites];
+		};
+
+		// Every thread that made a GLCall, kept alive after the thread exits so its counts still add up
+		static std::vector<std::unique_ptr<ThreadCounters>> s_Threads;
+		static thread_local ThreadCounters* t_Counters;
+		static thread_local std::chrono::steady_clock::time_point t_CallStart;
+
+		static ThreadCounters* RegisterThread();
+
+	public:
+		/**
+		* Maps a GLCall expression (e.g. "int location = glGetUniformLocation(...)") to the id of its entry point.
+		* Called once per call site, every site of the same entry point shares the id.
+		**/
+		static unsigned int RegisterSite(const char* expression);
+
+		inline static void BeginCall()
+		{
+			t_CallStart = std::chrono::steady_clock::now();
+		}
+
+		inline static void EndCall(unsigned int site)
+		{
+			uint64_t elapsed = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t_CallStart).count();
+			ThreadCounters* counters = t_Counters ? t_Counters : RegisterThread();
+			Counter& counter = counters->counters[site];
+			// Only this thread writes its counters, a relaxed load/store pair is enough and avoids locked instructions
+			counter.calls.store(counter.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			counter.nanoseconds.store(counter.nanoseconds.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+		}
+
+		// Sums every thread's counters and keeps what changed since the previous call, sorted by time
+		static void EndFrame();
+
+		// Entries of the last frame, most expensive first
+		static const std::vector<Entry>& GetFrameEntries();
+
+		static void Print(std::ostream& stream);
+};
@@ -0,0 +1,250 @@
+#include "GLStateCache.h"
+#include "Renderer.h"
+#include <algorithm>
+
+// Value no real binding can have, forces the next bind to reach the driver
+static const unsigned int UnknownBinding = 0xFFFFFFFF;
+
+GLStateCache::GLStateCache()
+    : m_Program(0), m_VertexArray(0), m_ActiveTextureUnit(0), m_RestartIndex(0), m_RestartKnown(true), m_Stats{ 0, 0 }
+{
+    // A fresh context has everything bound to 0
+    for (unsigned int& buffer : m_Buffers)
+        buffer = 0;
+    for (unsigned int& buffer : m_StorageBuffers)
+        buffer = 0;
+    for (TextureBinding& binding : m_Textures)
+        binding = { GL_TEXTURE_2D, 0 };
+}
+
+GLStateCache& GLStateCache::Get()
+{
+    // GL contexts are current per thread, so is their cache
+    static thread_local GLStateCache cache;
+    return cache;
+}
+
+int GLStateCache::GetBufferSlot(unsigned int target)
+{
+    switch (target) {
+        case GL_ARRAY_BUFFER: return ArrayBuffer;
+        case GL_UNIFORM_BUFFER: return UniformBuffer;
+        case GL_COPY_READ_BUFFER: return CopyReadBuffer;
+        case GL_COPY_WRITE_BUFFER: return CopyWriteBuffer;
+    }
+    return -1;
+}
+
+void GLStateCache::UseProgram(unsigned int program)
+{
+    if (m_Program == program) {
+        Hit();
+        return;
+    }
+    Miss();
+    GLCall(glUseProgram(program));
+    m_Program = program;
+}
+
+void GLStateCache::BindVertexArray(unsigned int vertexArray)
+{
+    if (m_VertexArray == vertexArray) {
+        Hit();
+        return;
+    }
+    Miss();
+    GLCall(glBindVertexArray(vertexArray));
+    m_VertexArray = vertexArray;
+}
+
+void GLStateCache::BindBuffer(unsigned int target, unsigned int buffer)
+{
+    unsigned int* current = nullptr;
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        // Binding an element buffer changes the bound VAO, which is why it is tracked per VAO
+        if (m_VertexArray != UnknownBinding) {
+            auto it = m_ElementBuffers.find(m_VertexArray);
+            current = it != m_ElementBuffers.end() ? &it->second : &(m_ElementBuffers[m_VertexArray] = UnknownBinding);
+        }
+    }
+    else {
+        int slot = GetBufferSlot(target);
+        if (slot >= 0)
+            current = &m_Buffers[slot];
+    }
+
+    if (current && *current == buffer) {
+        Hit();
+        return;
+    }
+    Miss();
+    GLCall(glBindBuffer(target, buffer));
+    if (current)
+        *current = buffer;
+}
+
+bool GLStateCache::UpdateVertexBuffer(unsigned int vertexArray, unsigned int binding, unsigned int buffer, uintptr_t offset, unsigned int stride)
+{
+    ASSERT(binding < MaxVertexBufferBindings);
+    if (vertexArray == UnknownBinding)
+        return true;
+    auto it = m_VertexBuffers.find(vertexArray);
+    if (it == m_VertexBuffers.end()) {
+        VertexBufferBindings unknown;
+        for (unsigned int i = 0; i < MaxVertexBufferBindings; i++)
+            unknown.buffer[i] = UnknownBinding;
+        it = m_VertexBuffers.emplace(vertexArray, unknown).first;
+    }
+    VertexBufferBindings& bindings = it->second;
+    if (bindings.buffer[binding] == buffer && bindings.offset[binding] == offset && bindings.stride[binding] == stride)
+        return false;
+    bindings.buffer[binding] = buffer;
+    bindings.offset[binding] = offset;
+    bindings.stride[binding] = stride;
+    return true;
+}
+
+void GLStateCache::BindVertexBuffer(unsigned int binding, unsigned int buffer, uintptr_t offset, unsigned int stride)
+{
+    if (!UpdateVertexBuffer(m_VertexArray, binding, buffer, offset, stride)) {
+        Hit();
+        return;
+    }
+    Miss();
+    GLCall(glBindVertexBuffer(binding, buffer, (GLintptr)offset, stride));
+}
+
+void GLStateCache::VertexArrayVertexBuffer(unsigned int vertexArray, unsigned int binding, unsigned int buffer, uintptr_t offset, unsigned int stride)
+{
+    if (!UpdateVertexBuffer(vertexArray, binding, buffer, offset, stride)) {
+        Hit();
+        return;
+    }
+    Miss();
+    GLCall(glVertexArrayVertexBuffer(vertexArray, binding, buffer, (GLintptr)offset, stride));
+}
+
+void GLStateCache::BindStorageBuffer(unsigned int index, unsigned int buffer)
+{
+    ASSERT(index < MaxStorageBindings);
+    if (m_StorageBuffers[index] == buffer) {
+        Hit();
+        return;
+    }
+    Miss();
+    GLCall(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, buffer));
+    m_StorageBuffers[index] = buffer;
+}
+
+void GLStateCache::BindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+    ASSERT(unit < MaxTextureUnits);
+    TextureBinding& binding = m_Textures[unit];
+    if (binding.target == target && binding.texture == texture) {
+        Hit();
+        return;
+    }
+    Miss();
+    if (m_ActiveTextureUnit != unit) {
+        GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+        m_ActiveTextureUnit = unit;
+    }
+    GLCall(glBindTexture(target, texture));
+    binding = { target, texture };
+}
+
+void GLStateCache::SetPrimitiveRestart(unsigned int restartIndex)
+{
+    if (m_RestartKnown && m_RestartIndex == restartIndex) {
+        Hit();
+        return;
+    }
+    Miss();
+    if (restartIndex == 0) {
+        GLCall(glDisable(GL_PRIMITIVE_RESTART));
+    }
+    else {
+        if (!m_RestartKnown || m_RestartIndex == 0) {
+            GLCall(glEnable(GL_PRIMITIVE_RESTART));
+        }
+        GLCall(glPrimitiveRestartIndex(restartIndex));
+    }
+    m_RestartIndex = restartIndex;
+    m_RestartKnown = true;
+}
+
+void GLStateCache::OnVertexArrayElementBuffer(unsigned int vertexArray, unsigned int buffer)
+{
+    m_ElementBuffers[vertexArray] = buffer;
+}
+
+void GLStateCache::OnDeleteProgram(unsigned int program)
+{
+    // A deleted program stays in use until another one is installed, don't trust the name afterwards
+    if (m_Program == program)
+        m_Program = UnknownBinding;
+}
+
+void GLStateCache::OnDeleteVertexArray(unsigned int vertexArray)
+{
+    if (m_VertexArray == vertexArray)
+        m_VertexArray = 0;
+    m_ElementBuffers.erase(vertexArray);
+    m_VertexBuffers.erase(vertexArray);
+}
+
+void GLStateCache::OnDeleteBuffer(unsigned int buffer)
+{
+    for (unsigned int& bound : m_Buffers)
+        if (bound == buffer)
+            bound = 0;
+    for (unsigned int& bound : m_StorageBuffers)
+        if (bound == buffer)
+            bound = 0;
+    // Other VAOs keep referencing the deleted object, mark them unknown so a reused name isn't mistaken for it
+    for (auto& elementBuffer : m_ElementBuffers)
+        if (elementBuffer.second == buffer)
+            elementBuffer.second = elementBuffer.first == m_VertexArray ? 0 : UnknownBinding;
+    for (auto& vertexBuffers : m_VertexBuffers)
+        for (unsigned int& bound : vertexBuffers.second.buffer)
+            if (bound == buffer)
+                bound = UnknownBinding;
+    for (const Listener& listener : m_DeleteBufferListeners)
+        listener.callback(listener.userData, buffer);
+}
+
+void GLStateCache::AddDeleteBufferListener(DeleteBufferListener callback, void* userData)
+{
+    m_DeleteBufferListeners.push_back({ callback, userData });
+}
+
+void GLStateCache::RemoveDeleteBufferListener(DeleteBufferListener callback, void* userData)
+{
+    auto it = std::find_if(m_DeleteBufferListeners.begin(), m_DeleteBufferListeners.end(),
+        [&](const Listener& listener) { return listener.callback == callback && listener.userData == userData; });
+    if (it != m_DeleteBufferListeners.end())
+        m_DeleteBufferListeners.erase(it);
+}
+
+void GLStateCache::OnDeleteTexture(unsigned int texture)
+{
+    for (TextureBinding& binding : m_Textures)
+        if (binding.texture == texture)
+            binding.texture = 0;
+}
+
+void GLStateCache::Invalidate()
+{
+    m_Program = UnknownBinding;
+    m_VertexArray = UnknownBinding;
+    for (unsigned int& buffer : m_Buffers)
+        buffer = UnknownBinding;
+    for (unsigned int& buffer : m_StorageBuffers)
+        buffer = UnknownBinding;
+    m_ElementBuffers.clear();
+    m_VertexBuffers.clear();
+    m_ActiveTextureUnit = UnknownBinding;
+    for (TextureBinding& binding : m_Textures)
+        binding = { GL_NONE, UnknownBinding };
+    m_RestartKnown = false;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+* Shadow copy of the GL binding state of the context current on this thread.
+* Every bind goes through here and is only forwarded to the driver when it changes something.
+* The cache assumes it sees every bind: raw glBind* calls made behind its back require Invalidate().
+**/
+class GLStateCache
+{
+	public:
+		// Told about every buffer deletion on the thread, for higher level caches keyed by buffer names
+		typedef void (*DeleteBufferListener)(void* userData, unsigned int buffer);
+
+		static const unsigned int MaxTextureUnits = 32;
+		static const unsigned int MaxVertexBufferBindings = 2;
+		static const unsigned int MaxStorageBindings = 8;	// GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS guaranteed by GL 4.3
+
+		struct Stats
+		{
+			unsigned int hits;   // calls skipped because the state was already set
+			unsigned int misses; // calls forwarded to the driver
+		};
+
+	private:
+		// Tracked buffer targets, GL_ELEMENT_ARRAY_BUFFER is stored per VAO since it is part of the VAO state
+		enum BufferSlot { ArrayBuffer = 0, UniformBuffer, CopyReadBuffer, CopyWriteBuffer, BufferSlotCount };
+
+		struct TextureBinding
+		{
+			unsigned int target;
+			unsigned int texture;
+		};
+
+		// Vertex buffer binding points of one VAO (ARB_vertex_attrib_binding)
+		struct VertexBufferBindings
+		{
+			unsigned int buffer[MaxVertexBufferBindings];
+			uintptr_t offset[MaxVertexBufferBindings];
+			unsigned int stride[MaxVertexBufferBindings];
+		};
+
+		unsigned int m_Program;
+		unsigned int m_VertexArray;
+		unsigned int m_Buffers[BufferSlotCount];
+		std::unordered_map<unsigned int, unsigned int> m_ElementBuffers; // VAO -> element buffer
+		std::unordered_map<unsigned int, VertexBufferBindings> m_VertexBuffers; // VAO -> vertex buffer binding points
+		unsigned int m_StorageBuffers[MaxStorageBindings];
+		unsigned int m_ActiveTextureUnit;
+		unsigned int m_RestartIndex;	// 0 when primitive restart is disabled
+		bool m_RestartKnown;
+		TextureBinding m_Textures[MaxTextureUnits];
+		Stats m_Stats;
+
+		struct Listener
+		{
+			DeleteBufferListener callback;
+			void* userData;
+		};
+		std::vector<Listener> m_DeleteBufferListeners;
+
+		static int GetBufferSlot(unsigned int target);
+		// Returns false when the binding point of vertexArray already holds exactly this, records it otherwise
+		bool UpdateVertexBuffer(unsigned int vertexArray, unsigned int binding, unsigned int buffer, uintptr_t offset, unsigned int stride);
+
+		inline void Hit() { m_Stats.hits++; }
+		inline void Miss() { m_Stats.misses++; }
+
+	public:
+		GLStateCache();
+
+		// Cache of the context current on the calling thread
+		static GLStateCache& Get();
+
+		void UseProgram(unsigned int program);
+		void BindVertexArray(unsigned int vertexArray);
+		void BindBuffer(unsigned int target, unsigned int buffer);
+		void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+		// Binding point of the bound VAO, glBindVertexBuffer
+		void BindVertexBuffer(unsigned int binding, unsigned int buffer, uintptr_t offset, unsigned int stride);
+		// Same by name without binding the VAO, glVertexArrayVertexBuffer
+		void VertexArrayVertexBuffer(unsigned int vertexArray, unsigned int binding, unsigned int buffer, uintptr_t offset, unsigned int stride);
+		// Indexed GL_SHADER_STORAGE_BUFFER binding, glBindBufferBase
+		void BindStorageBuffer(unsigned int index, unsigned int buffer);
+		// Enables primitive restart with the given index, 0 disables it
+		void SetPrimitiveRestart(unsigned int restartIndex);
+
+		// Records an element buffer attached by name (glVertexArrayElementBuffer), no GL call
+		void OnVertexArrayElementBuffer(unsigned int vertexArray, unsigned int buffer);
+
+		// GL resets the bindings of deleted objects to 0, these keep the cache in sync
+		void OnDeleteProgram(unsigned int program);
+		void OnDeleteVertexArray(unsigned int vertexArray);
+		// Also calls the delete buffer listeners
+		void OnDeleteBuffer(unsigned int buffer);
+		void OnDeleteTexture(unsigned int texture);
+
+		// Remove with the same pair before userData goes away
+		void AddDeleteBufferListener(DeleteBufferListener callback, void* userData);
+		void RemoveDeleteBufferListener(DeleteBufferListener callback, void* userData);
+
+		// Forget everything, the next bind of each kind always reaches the driver
+		void Invalidate();
+
+		inline unsigned int GetProgram() const { return m_Program; }
+		inline unsigned int GetVertexArray() const { return m_VertexArray; }
+
+		inline const Stats& GetFrameStats() const { return m_Stats; }
+		inline void ResetFrameStats() { m_Stats = { 0, 0 }; }
+};
@@ -0,0 +1,342 @@
+#include "GpuHeap.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "GLDeletionQueue.h"
+#include <algorithm>
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+const unsigned int GpuHeap::Granularity;
+const unsigned int GpuHeap::InvalidHandle;
+
+static unsigned int MostSignificantBit(unsigned int x)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, x);
+    return index;
+#else
+    return 31 - __builtin_clz(x);
+#endif
+}
+
+static unsigned int LeastSignificantBit(unsigned int x)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return index;
+#else
+    return __builtin_ctz(x);
+#endif
+}
+
+static unsigned int RoundUp(unsigned int x, unsigned int multiple)
+{
+    return (x + multiple - 1) / multiple * multiple;
+}
+
+/**
+* Size class of a block: the first level is the power of two range, the second splits it linearly.
+* Sizes are counted in Granularity units, the ones below SecondLevelCount units all go to the first level 0.
+**/
+static void MapSize(unsigned int units, unsigned int secondLevelBits, unsigned int& firstLevel, unsigned int& secondLevel)
+{
+    unsigned int secondLevelCount = 1u << secondLevelBits;
+    if (units < secondLevelCount) {
+        firstLevel = 0;
+        secondLevel = units;
+        return;
+    }
+    unsigned int msb = MostSignificantBit(units);
+    firstLevel = msb - secondLevelBits + 1;
+    secondLevel = (units >> (msb - secondLevelBits)) - secondLevelCount;
+}
+
+GpuHeap::GpuHeap(unsigned int pageSize)
+    : m_PageSize(RoundUp(pageSize, Granularity)), m_AllocationCount(0), m_FirstLevelMap(0), m_SecondLevelMaps()
+{
+    for (auto& lists : m_FreeLists)
+        std::fill(std::begin(lists), std::end(lists), InvalidHandle);
+}
+
+GpuHeap::~GpuHeap()
+{
+    GLStateCache& state = GLStateCache::Get();
+    for (const Page& page : m_Pages) {
+        GLCall(glDeleteBuffers(1, &page.buffer));
+        state.OnDeleteBuffer(page.buffer);
+    }
+}
+
+unsigned int GpuHeap::NewBlock()
+{
+    if (!m_RecycledBlocks.empty()) {
+        unsigned int block = m_RecycledBlocks.back();
+        m_RecycledBlocks.pop_back();
+        return block;
+    }
+    m_Blocks.emplace_back();
+    return (unsigned int)m_Blocks.size() - 1;
+}
+
+void GpuHeap::RecycleBlock(unsigned int block)
+{
+    m_Blocks[block].page = InvalidHandle;
+    m_RecycledBlocks.push_back(block);
+}
+
+void GpuHeap::InsertFree(unsigned int block)
+{
+    Block& b = m_Blocks[block];
+    unsigned int fl, sl;
+    MapSize(b.size / Granularity, SecondLevelBits, fl, sl);
+
+    b.free = true;
+    b.prevFree = InvalidHandle;
+    b.nextFree = m_FreeLists[fl][sl];
+    if (b.nextFree != InvalidHandle)
+        m_Blocks[b.nextFree].prevFree = block;
+    m_FreeLists[fl][sl] = block;
+    m_FirstLevelMap |= 1u << fl;
+    m_SecondLevelMaps[fl] |= 1u << sl;
+}
+
+void GpuHeap::RemoveFree(unsigned int block)
+{
+    Block& b = m_Blocks[block];
+    unsigned int fl, sl;
+    MapSize(b.size / Granularity, SecondLevelBits, fl, sl);
+
+    if (b.prevFree != InvalidHandle)
+        m_Blocks[b.prevFree].nextFree = b.nextFree;
+    else
+        m_FreeLists[fl][sl] = b.nextFree;
+    if (b.nextFree != InvalidHandle)
+        m_Blocks[b.nextFree].prevFree = b.prevFree;
+
+    if (m_FreeLists[fl][sl] == InvalidHandle) {
+        m_SecondLevelMaps[fl] &= ~(1u << sl);
+        if (!m_SecondLevelMaps[fl])
+            m_FirstLevelMap &= ~(1u << fl);
+    }
+    b.free = false;
+}
+
+// Any block of the returned class is big enough: the request is rounded up to the next class boundary
+unsigned int GpuHeap::FindFree(unsigned int size) const
+{
+    unsigned int units = size / Granularity;
+    if (units >= SecondLevelCount)
+        units += (1u << (MostSignificantBit(units) - SecondLevelBits)) - 1;
+    unsigned int fl, sl;
+    MapSize(units, SecondLevelBits, fl, sl);
+    if (fl >= FirstLevelCount)
+        return InvalidHandle;
+
+    unsigned int secondLevelMap = m_SecondLevelMaps[fl] & (~0u << sl);
+    if (!secondLevelMap) {
+        unsigned int firstLevelMap = fl + 1 < FirstLevelCount ? m_FirstLevelMap & (~0u << (fl + 1)) : 0;
+        if (!firstLevelMap)
+            return InvalidHandle;
+        fl = LeastSignificantBit(firstLevelMap);
+        secondLevelMap = m_SecondLevelMaps[fl];
+    }
+    return m_FreeLists[fl][LeastSignificantBit(secondLevelMap)];
+}
+
+unsigned int GpuHeap::AddPage(unsigned int size)
+{
+    Page page;
+    page.size = size;
+    GLCall(glGenBuffers(1, &page.buffer));
+    // The copy target leaves the array and element bindings of the current VAO alone
+    GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, page.buffer);
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW));
+
+    page.firstBlock = NewBlock();
+    Block& b = m_Blocks[page.firstBlock];
+    b.page = (unsigned int)m_Pages.size();
+    b.offset = 0;
+    b.size = size;
+    b.prevPhysical = InvalidHandle;
+    b.nextPhysical = InvalidHandle;
+    m_Pages.push_back(page);
+    InsertFree(page.firstBlock);
+    return page.firstBlock;
+}
+
+GpuHeap::Allocation GpuHeap::Allocate(unsigned int size, unsigned int alignment)
+{
+    ASSERT(alignment > 0);
+    // Room for the data wherever the alignment lands inside the block
+    unsigned int blockSize = RoundUp(std::max(size, 1u) + alignment - 1, Granularity);
+
+    unsigned int block = FindFree(blockSize);
+    if (block == InvalidHandle) {
+        // Taken directly: a dedicated page is exactly blockSize, which FindFree's rounding up would miss
+        block = AddPage(std::max(m_PageSize, blockSize));
+    }
+    RemoveFree(block);
+
+    // Give the tail back if it can hold a block of its own
+    if (m_Blocks[block].size - blockSize >= Granularity) {
+        unsigned int rest = NewBlock();
+        Block& b = m_Blocks[block];
+        Block& r = m_Blocks[rest];
+        r.page = b.page;
+        r.offset = b.offset + blockSize;
+        r.size = b.size - blockSize;
+        r.prevPhysical = block;
+        r.nextPhysical = b.nextPhysical;
+        if (r.nextPhysical != InvalidHandle)
+            m_Blocks[r.nextPhysical].prevPhysical = rest;
+        b.nextPhysical = rest;
+        b.size = blockSize;
+        InsertFree(rest);
+    }
+
+    Block& b = m_Blocks[block];
+    b.alignment = alignment;
+    b.dataOffset = RoundUp(b.offset, alignment);
+    b.dataSize = size;
+    m_AllocationCount++;
+    return { block, m_Pages[b.page].buffer, b.dataOffset };
+}
+
+void GpuHeap::Free(unsigned int handle)
+{
+    ASSERT(handle < m_Blocks.size() && !m_Blocks[handle].free);
+    m_AllocationCount--;
+
+    // Merge with free neighbours so free space never stays split at a boundary
+    unsigned int block = handle;
+    unsigned int next = m_Blocks[block].nextPhysical;
+    if (next != InvalidHandle && m_Blocks[next].free) {
+        RemoveFree(next);
+        m_Blocks[block].size += m_Blocks[next].size;
+        m_Blocks[block].nextPhysical = m_Blocks[next].nextPhysical;
+        if (m_Blocks[block].nextPhysical != InvalidHandle)
+            m_Blocks[m_Blocks[block].nextPhysical].prevPhysical = block;
+        RecycleBlock(next);
+    }
+    unsigned int prev = m_Blocks[block].prevPhysical;
+    if (prev != InvalidHandle && m_Blocks[prev].free) {
+        RemoveFree(prev);
+        m_Blocks[prev].size += m_Blocks[block].size;
+        m_Blocks[prev].nextPhysical = m_Blocks[block].nextPhysical;
+        if (m_Blocks[prev].nextPhysical != InvalidHandle)
+            m_Blocks[m_Blocks[prev].nextPhysical].prevPhysical = prev;
+        RecycleBlock(block);
+        block = prev;
+    }
+    InsertFree(block);
+}
+
+void GpuHeap::Upload(unsigned int handle, const void* data, unsigned int size, unsigned int offset)
+{
+    const Block& b = m_Blocks[handle];
+    ASSERT(offset + size <= b.dataSize);
+    GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, m_Pages[b.page].buffer);
+    GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, b.dataOffset + offset, size, data));
+}
+
+// Copies the allocations of the page back to back into a new buffer, leaving a single free block at the end
+unsigned int GpuHeap::CompactPage(Page& page)
+{
+    // GL can't copy between overlapping ranges of the same buffer, so the packed page goes to a new one
+    unsigned int buffer;
+    GLCall(glGenBuffers(1, &buffer));
+    GLStateCache& state = GLStateCache::Get();
+    state.BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, page.size, nullptr, GL_STATIC_DRAW));
+    state.BindBuffer(GL_COPY_READ_BUFFER, page.buffer);
+
+    unsigned int moved = 0;
+    unsigned int cursor = 0;
+    unsigned int last = InvalidHandle;
+    for (unsigned int block = page.firstBlock; block != InvalidHandle;) {
+        Block& b = m_Blocks[block];
+        unsigned int next = b.nextPhysical;
+        if (b.free) {
+            RemoveFree(block);
+            RecycleBlock(block);
+            block = next;
+            continue;
+        }
+
+        unsigned int dataOffset = RoundUp(cursor, b.alignment);
+        GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, b.dataOffset, dataOffset, b.dataSize));
+        if (dataOffset != b.dataOffset)
+            moved++;
+        b.offset = cursor;
+        b.dataOffset = dataOffset;
+        b.prevPhysical = last;
+        if (last == InvalidHandle)
+            page.firstBlock = block;
+        else
+            m_Blocks[last].nextPhysical = block;
+        cursor += b.size;
+        last = block;
+        block = next;
+    }
+
+    if (cursor < page.size) {
+        unsigned int rest = NewBlock();
+        Block& r = m_Blocks[rest];
+        r.page = (unsigned int)(&page - m_Pages.data());
+        r.offset = cursor;
+        r.size = page.size - cursor;
+        r.prevPhysical = last;
+        r.nextPhysical = InvalidHandle;
+        if (last == InvalidHandle)
+            page.firstBlock = rest;
+        else
+            m_Blocks[last].nextPhysical = rest;
+        last = rest;
+        InsertFree(rest);
+    }
+    m_Blocks[last].nextPhysical = InvalidHandle;
+
+    // Draws already queued may still read the old storage
+    GLDeletionQueue::Get().DeleteBuffer(page.buffer);
+    page.buffer = buffer;
+    return moved;
+}
+
+unsigned int GpuHeap::Defragment()
+{
+    unsigned int moved = 0;
+    for (Page& page : m_Pages) {
+        // Pages whose only free block is the last one are already packed
+        bool hasHoles = false;
+        for (unsigned int block = page.firstBlock; block != InvalidHandle; block = m_Blocks[block].nextPhysical) {
+            if (m_Blocks[block].free && m_Blocks[block].nextPhysical != InvalidHandle) {
+                hasHoles = true;
+                break;
+            }
+        }
+        if (hasHoles)
+            moved += CompactPage(page);
+    }
+    return moved;
+}
+
+GpuHeap::Stats GpuHeap::GetStats() const
+{
+    Stats stats = {};
+    stats.pages = (unsigned int)m_Pages.size();
+    stats.allocations = m_AllocationCount;
+    for (const Page& page : m_Pages)
+        stats.reservedBytes += page.size;
+    for (const Block& b : m_Blocks) {
+        if (b.page == InvalidHandle || !b.free)
+            continue;
+        stats.freeBytes += b.size;
+        stats.freeBlocks++;
+        stats.largestFreeBlock = std::max(stats.largestFreeBlock, b.size);
+    }
+    stats.fragmentation = stats.freeBytes ? 1.0f - (float)stats.largestFreeBlock / stats.freeBytes : 0.0f;
+    return stats;
+}
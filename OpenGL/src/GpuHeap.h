@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+
+/**
+* Sub-allocator carving vertex and index data out of a few large GL buffers (pages) instead of one
+* buffer per mesh. Free space is tracked with a two level segregated fit (TLSF) index, so allocating
+* and freeing are constant time and neighbouring free blocks are merged on free.
+* Defragment() packs the live allocations of fragmented pages, which moves them: offsets handed out
+* before have to be queried again afterwards.
+**/
+class GpuHeap
+{
+	public:
+		static const unsigned int Granularity = 16;	// block sizes and offsets are multiples of this
+		static const unsigned int InvalidHandle = 0xFFFFFFFF;
+
+		struct Allocation
+		{
+			unsigned int handle;	// identifies the allocation for Free, Upload and the lookups
+			unsigned int buffer;	// GL buffer of its page
+			unsigned int offset;	// byte offset inside that buffer
+		};
+
+		struct Stats
+		{
+			unsigned int pages;
+			unsigned int allocations;
+			unsigned int reservedBytes;		// size of every page together
+			unsigned int freeBytes;
+			unsigned int freeBlocks;
+			unsigned int largestFreeBlock;
+			float fragmentation;			// 1 - largest free block / free bytes, 0 when all free space is contiguous
+		};
+
+	private:
+		static const unsigned int SecondLevelBits = 4;
+		static const unsigned int SecondLevelCount = 1 << SecondLevelBits;
+		static const unsigned int FirstLevelCount = 32;
+
+		struct Page
+		{
+			unsigned int buffer;
+			unsigned int size;
+			unsigned int firstBlock;
+		};
+
+		// Blocks of a page form a list in address order, free blocks are also linked in their size class
+		struct Block
+		{
+			unsigned int page;			// InvalidHandle once the node is recycled
+			unsigned int offset;
+			unsigned int size;
+			unsigned int prevPhysical;
+			unsigned int nextPhysical;
+			unsigned int prevFree;
+			unsigned int nextFree;
+			bool free;
+
+			// Allocated blocks only: the data starts at the first multiple of alignment inside the block
+			unsigned int alignment;
+			unsigned int dataOffset;
+			unsigned int dataSize;
+		};
+
+		unsigned int m_PageSize;
+		std::vector<Page> m_Pages;
+		std::vector<Block> m_Blocks;
+		std::vector<unsigned int> m_RecycledBlocks;
+		unsigned int m_AllocationCount;
+
+		unsigned int m_FirstLevelMap;
+		unsigned int m_SecondLevelMaps[FirstLevelCount];
+		unsigned int m_FreeLists[FirstLevelCount][SecondLevelCount];
+
+		unsigned int NewBlock();
+		void RecycleBlock(unsigned int block);
+		void InsertFree(unsigned int block);
+		void RemoveFree(unsigned int block);
+		unsigned int FindFree(unsigned int size) const;
+		// Returns the page's single free block
+		unsigned int AddPage(unsigned int size);
+		unsigned int CompactPage(Page& page);
+
+	public:
+		// Pages are pageSize bytes, bigger allocations get a page of their own
+		explicit GpuHeap(unsigned int pageSize = 16 * 1024 * 1024);
+		~GpuHeap();
+
+		GpuHeap(const GpuHeap&) = delete;
+		GpuHeap& operator=(const GpuHeap&) = delete;
+
+		/**
+		* Reserves size bytes whose offset is a multiple of alignment, which doesn't need to be a power of two:
+		* pass the vertex stride so the data can be drawn with a base vertex
+		**/
+		Allocation Allocate(unsigned int size, unsigned int alignment = 4);
+		void Free(unsigned int handle);
+
+		// Copies data into the allocation, starting offset bytes in
+		void Upload(unsigned int handle, const void* data, unsigned int size, unsigned int offset = 0);
+
+		/**
+		* Packs the allocations of every page with holes into a fresh buffer using glCopyBufferSubData
+		* Returns the number of allocations moved, their buffer and offset have changed if it isn't 0
+		**/
+		unsigned int Defragment();
+
+		inline unsigned int GetBuffer(unsigned int handle) const { return m_Pages[m_Blocks[handle].page].buffer; }
+		inline unsigned int GetOffset(unsigned int handle) const { return m_Blocks[handle].dataOffset; }
+		inline unsigned int GetSize(unsigned int handle) const { return m_Blocks[handle].dataSize; }
+
+		Stats GetStats() const;
+};
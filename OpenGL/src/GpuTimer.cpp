@@ -0,0 +1,93 @@
+#include "GpuTimer.h"
+#include "Renderer.h"
+#include "Instrumentor.h"
+
+GpuTimer::GpuTimer()
+    : m_Frame(0), m_InPass(false), m_DroppedPasses(0), m_GpuReference(0), m_CpuReference(0.0)
+{
+    Calibrate();
+}
+
+GpuTimer::~GpuTimer()
+{
+    for (std::vector<Pass>& passes : m_Frames)
+        for (const Pass& pass : passes) {
+            m_FreeQueries.push_back(pass.startQuery);
+            m_FreeQueries.push_back(pass.elapsedQuery);
+        }
+    if (!m_FreeQueries.empty()) {
+        GLCall(glDeleteQueries((GLsizei)m_FreeQueries.size(), m_FreeQueries.data()));
+    }
+}
+
+unsigned int GpuTimer::AcquireQuery()
+{
+    if (m_FreeQueries.empty()) {
+        unsigned int query;
+        GLCall(glGenQueries(1, &query));
+        return query;
+    }
+    unsigned int query = m_FreeQueries.back();
+    m_FreeQueries.pop_back();
+    return query;
+}
+
+void GpuTimer::Calibrate()
+{
+    // Returns once previous commands reached the driver, it doesn't wait for the GPU to execute them
+    GLint64 gpuNow;
+    GLCall(glGetInteger64v(GL_TIMESTAMP, &gpuNow));
+    m_GpuReference = gpuNow;
+    m_CpuReference = Instrumentor::Get().Now();
+}
+
+void GpuTimer::CollectFrame(std::vector<Pass>& passes)
+{
+    Instrumentor& instrumentor = Instrumentor::Get();
+    for (const Pass& pass : passes) {
+        GLint available = GL_FALSE;
+        GLCall(glGetQueryObjectiv(pass.elapsedQuery, GL_QUERY_RESULT_AVAILABLE, &available));
+        if (available) {
+            GLuint64 start, elapsed;
+            GLCall(glGetQueryObjectui64v(pass.startQuery, GL_QUERY_RESULT, &start));
+            GLCall(glGetQueryObjectui64v(pass.elapsedQuery, GL_QUERY_RESULT, &elapsed));
+            double startUs = m_CpuReference + ((int64_t)start - m_GpuReference) / 1000.0;
+            instrumentor.WriteGpuProfile({ pass.name, startUs, elapsed / 1000.0, 0 });
+        }
+        else {
+            m_DroppedPasses++;
+        }
+        m_FreeQueries.push_back(pass.startQuery);
+        m_FreeQueries.push_back(pass.elapsedQuery);
+    }
+    passes.clear();
+}
+
+void GpuTimer::BeginFrame()
+{
+    ASSERT(!m_InPass);
+    m_Frame = (m_Frame + 1) % FrameLatency;
+    // This slot was last filled FrameLatency frames ago, its results should be ready by now
+    CollectFrame(m_Frames[m_Frame]);
+
+    // GPU and CPU clocks drift apart, re-anchor them once per cycle through the slots
+    if (m_Frame == 0)
+        Calibrate();
+}
+
+void GpuTimer::BeginPass(const char* name)
+{
+    ASSERT(!m_InPass);
+    m_InPass = true;
+    Pass pass = { name, AcquireQuery(), AcquireQuery() };
+    GLCall(glQueryCounter(pass.startQuery, GL_TIMESTAMP));
+    GLCall(glBeginQuery(GL_TIME_ELAPSED, pass.elapsedQuery));
+    m_Frames[m_Frame].push_back(pass);
+}
+
+void GpuTimer::EndPass()
+{
+    ASSERT(m_InPass);
+    m_InPass = false;
+    GLCall(glEndQuery(GL_TIME_ELAPSED));
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Instrumentor.h"
+
+/**
+* GL_TIME_ELAPSED queries around render passes, reported to the Instrumentor on the GPU track.
+* Queries are kept for FrameLatency frames before being read, results that are still not ready are
+* dropped instead of waited on so the CPU never stalls on the GPU.
+**/
+class GpuTimer
+{
+	public:
+		static const unsigned int FrameLatency = 3;
+
+	private:
+		struct Pass
+		{
+			const char* name;
+			unsigned int startQuery;	// GL_TIMESTAMP, places the pass on the trace timeline
+			unsigned int elapsedQuery;	// GL_TIME_ELAPSED, its duration
+		};
+
+		std::vector<Pass> m_Frames[FrameLatency];
+		std::vector<unsigned int> m_FreeQueries;
+		unsigned int m_Frame;
+		bool m_InPass;
+		unsigned int m_DroppedPasses;
+
+		// GPU timestamp (ns) and trace time (us) sampled together, to convert one into the other
+		int64_t m_GpuReference;
+		double m_CpuReference;
+
+		unsigned int AcquireQuery();
+		void Calibrate();
+		void CollectFrame(std::vector<Pass>& passes);
+
+	public:
+		GpuTimer();
+		~GpuTimer();
+
+		GpuTimer(const GpuTimer&) = delete;
+		GpuTimer& operator=(const GpuTimer&) = delete;
+
+		// Reports the passes of the frame issued FrameLatency frames ago and starts recording a new one
+		void BeginFrame();
+
+		// Passes can't nest, GL allows a single active GL_TIME_ELAPSED query
+		void BeginPass(const char* name);
+		void EndPass();
+
+		// Passes whose results were not available in time
+		inline unsigned int GetDroppedPasses() const { return m_DroppedPasses; }
+};
+
+class GpuPassScope
+{
+	private:
+		GpuTimer& m_Timer;
+
+	public:
+		GpuPassScope(GpuTimer& timer, const char* name) : m_Timer(timer) { m_Timer.BeginPass(name); }
+		~GpuPassScope() { m_Timer.EndPass(); }
+};
+
+#if GL_TRACE
+#define PROFILE_GPU_PASS(timer, name) GpuPassScope PROFILE_CONCAT(gpuPass, __LINE__)(timer, name)
+#else
+#define PROFILE_GPU_PASS(timer, name)
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+* Weak reference to an object in a HandlePool. The generation tells a live object apart from a newer
+* one reusing the same slot, so a stale handle resolves to null instead of to the wrong object.
+**/
+template<typename T>
+struct Handle
+{
+	uint32_t index = 0;
+	uint32_t generation = 0;	// 0 is never handed out, a default handle is always invalid
+
+	inline bool IsValid() const { return generation != 0; }
+	inline bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+	inline bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+/**
+* Dense generational pool: objects are stored contiguously and stay contiguous when destroyed
+* (the last one is moved into the hole), handles go through a slot table to find them.
+* T must be movable. Pointers returned by Get are invalidated by Create and Destroy, handles are not.
+**/
+template<typename T>
+class HandlePool
+{
+	private:
+		static const uint32_t InvalidIndex = 0xFFFFFFFF;
+
+		struct Slot
+		{
+			uint32_t dense;			// index in m_Objects, InvalidIndex when free
+			uint32_t generation;
+		};
+
+		std::vector<T> m_Objects;
+		std::vector<uint32_t> m_ObjectSlots;	// slot of every object, parallel to m_Objects
+		std::vector<Slot> m_Slots;
+		std::vector<uint32_t> m_FreeSlots;
+
+	public:
+		template<typename... Args>
+		Handle<T> Create(Args&&... args)
+		{
+			uint32_t slot;
+			if (!m_FreeSlots.empty()) {
+				slot = m_FreeSlots.back();
+				m_FreeSlots.pop_back();
+			}
+			else {
+				slot = (uint32_t)m_Slots.size();
+				m_Slots.push_back({ InvalidIndex, 1 });
+			}
+			m_Objects.emplace_back(std::forward<Args>(args)...);
+			m_ObjectSlots.push_back(slot);
+			m_Slots[slot].dense = (uint32_t)m_Objects.size() - 1;
+			return { slot, m_Slots[slot].generation };
+		}
+
+		// Returns false if the handle was already stale
+		bool Destroy(Handle<T> handle)
+		{
+			T* object = Get(handle);
+			if (!object)
+				return false;
+
+			uint32_t dense = m_Slots[handle.index].dense;
+			uint32_t last = (uint32_t)m_Objects.size() - 1;
+			if (dense != last) {
+				*object = std::move(m_Objects[last]);
+				m_ObjectSlots[dense] = m_ObjectSlots[last];
+				m_Slots[m_ObjectSlots[dense]].dense = dense;
+			}
+			m_Objects.pop_back();
+			m_ObjectSlots.pop_back();
+
+			Slot& slot = m_Slots[handle.index];
+			slot.dense = InvalidIndex;
+			// Skip 0 on wrap around so a recycled slot never matches a default handle
+			if (++slot.generation == 0)
+				slot.generation = 1;
+			m_FreeSlots.push_back(handle.index);
+			return true;
+		}
+
+		// Null when the handle is stale
+		inline T* Get(Handle<T> handle)
+		{
+			if (handle.index >= m_Slots.size() || m_Slots[handle.index].generation != handle.generation ||
+				m_Slots[handle.index].dense == InvalidIndex)
+				return nullptr;
+			return &m_Objects[m_Slots[handle.index].dense];
+		}
+
+		inline const T* Get(Handle<T> handle) const { return const_cast<HandlePool*>(this)->Get(handle); }
+
+		inline size_t GetSize() const { return m_Objects.size(); }
+
+		// The live objects, in no particular order
+		inline typename std::vector<T>::iterator begin() { return m_Objects.begin(); }
+		inline typename std::vector<T>::iterator end() { return m_Objects.end(); }
+		inline typename std::vector<T>::const_iterator begin() const { return m_Objects.begin(); }
+		inline typename std::vector<T>::const_iterator end() const { return m_Objects.end(); }
+};
@@ -0,0 +1,293 @@
+#include "HeadlessContext.h"
+
+#include <GL/glew.h>
+#include <cstring>
+
+#if defined(GL_HEADLESS_EGL)
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#elif defined(GL_HEADLESS_OSMESA)
+    #include <GL/osmesa.h>
+#else
+    #include <GLFW/glfw3.h>
+#endif
+
+HeadlessContext::HeadlessContext()
+    : m_Display(nullptr), m_Context(nullptr), m_Config(nullptr), m_Surface(nullptr), m_Owner(true), m_Width(0), m_Height(0)
+{
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    Destroy();
+}
+
+unsigned int HeadlessContext::InitGLEW()
+{
+    GLenum error = glewInit();
+#if defined(GL_HEADLESS_EGL) || defined(GL_HEADLESS_OSMESA)
+    // A GLEW built for GLX loads the GL functions first and only then fails to find a GLX display, which
+    // an EGL or OSMesa context never has. Everything this context needs is loaded at that point.
+    if (error == GLEW_ERROR_NO_GLX_DISPLAY)
+        return GLEW_OK;
+#endif
+    return error;
+}
+
+#if defined(GL_HEADLESS_EGL)
+
+const char* HeadlessContext::GetBackendName()
+{
+    return "EGL";
+}
+
+static bool HasExtension(EGLDisplay display, const char* name)
+{
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!extensions)
+        return false;
+    const size_t length = strlen(name);
+    for (const char* found = strstr(extensions, name); found; found = strstr(found + length, name)) {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+            return true;
+    }
+    return false;
+}
+
+// Contexts are only made current without a surface when the display allows it, else each gets a 1x1 pbuffer
+static bool CreateSurfaceIfNeeded(EGLDisplay display, EGLConfig config, void*& surface)
+{
+    if (HasExtension(display, "EGL_KHR_surfaceless_context"))
+        return true;
+    const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    EGLSurface pbuffer = eglCreatePbufferSurface(display, config, pbufferAttribs);
+    if (pbuffer == EGL_NO_SURFACE)
+        return false;
+    surface = pbuffer;
+    return true;
+}
+
+static EGLContext CreateCoreContext(EGLDisplay display, EGLConfig config, EGLContext share)
+{
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    return eglCreateContext(display, config, share, contextAttribs);
+}
+
+bool HeadlessContext::Create(int width, int height)
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    // Prefer Mesa's surfaceless platform, it needs neither X11 nor a DRM device
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        return false;
+    m_Display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+        return false;
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0)
+        return false;
+    m_Config = config;
+
+    if (!CreateSurfaceIfNeeded(display, config, m_Surface))
+        return false;
+
+    EGLContext context = CreateCoreContext(display, config, EGL_NO_CONTEXT);
+    if (context == EGL_NO_CONTEXT)
+        return false;
+    m_Context = context;
+
+    return MakeCurrent();
+}
+
+bool HeadlessContext::CreateShared(const HeadlessContext& share)
+{
+    m_Owner = false;
+    m_Display = share.m_Display;
+    m_Config = share.m_Config;
+    // An EGL surface is current on one thread at a time, the worker can't borrow the creator's pbuffer
+    if (!CreateSurfaceIfNeeded(m_Display, m_Config, m_Surface))
+        return false;
+    EGLContext context = CreateCoreContext(share.m_Display, share.m_Config, share.m_Context);
+    if (context == EGL_NO_CONTEXT)
+        return false;
+    m_Context = context;
+    return true;
+}
+
+bool HeadlessContext::MakeCurrent()
+{
+    EGLSurface surface = m_Surface ? (EGLSurface)m_Surface : EGL_NO_SURFACE;
+    return eglMakeCurrent(m_Display, surface, surface, m_Context) == EGL_TRUE;
+}
+
+void HeadlessContext::ReleaseCurrent()
+{
+    eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void HeadlessContext::Destroy()
+{
+    // A shared context is current on its worker only, which released it: don't touch the calling thread's
+    if (m_Display && m_Owner)
+        ReleaseCurrent();
+    if (m_Context)
+        eglDestroyContext(m_Display, m_Context);
+    if (m_Surface)
+        eglDestroySurface(m_Display, m_Surface);
+    if (m_Display && m_Owner)
+        eglTerminate(m_Display);
+    m_Context = nullptr;
+    m_Surface = nullptr;
+    m_Display = nullptr;
+}
+
+#elif defined(GL_HEADLESS_OSMESA)
+
+const char* HeadlessContext::GetBackendName()
+{
+    return "OSMesa";
+}
+
+static OSMesaContext CreateCoreContext(OSMesaContext share)
+{
+    const int attribs[] = {
+        OSMESA_FORMAT, OSMESA_RGBA,
+        OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, 3,
+        OSMESA_CONTEXT_MINOR_VERSION, 3,
+        0
+    };
+    return OSMesaCreateContextAttribs(attribs, share);
+}
+
+bool HeadlessContext::Create(int width, int height)
+{
+    OSMesaContext context = CreateCoreContext(nullptr);
+    if (!context)
+        return false;
+    m_Context = context;
+
+    m_Width = width;
+    m_Height = height;
+    m_Backbuffer.resize((size_t)width * height * 4);
+    return MakeCurrent();
+}
+
+bool HeadlessContext::CreateShared(const HeadlessContext& share)
+{
+    m_Owner = false;
+    OSMesaContext context = CreateCoreContext((OSMesaContext)share.m_Context);
+    if (!context)
+        return false;
+    m_Context = context;
+
+    // Every OSMesa context draws into a buffer of its own, the shared one only needs something to be current with
+    m_Width = 1;
+    m_Height = 1;
+    m_Backbuffer.resize(4);
+    return true;
+}
+
+bool HeadlessContext::MakeCurrent()
+{
+    return OSMesaMakeCurrent((OSMesaContext)m_Context, m_Backbuffer.data(), GL_UNSIGNED_BYTE, m_Width, m_Height) == GL_TRUE;
+}
+
+void HeadlessContext::ReleaseCurrent()
+{
+    OSMesaMakeCurrent(nullptr, nullptr, 0, 0, 0);
+}
+
+void HeadlessContext::Destroy()
+{
+    if (m_Context)
+        OSMesaDestroyContext((OSMesaContext)m_Context);
+    m_Context = nullptr;
+    m_Backbuffer.clear();
+}
+
+#else
+
+const char* HeadlessContext::GetBackendName()
+{
+    return "hidden GLFW window";
+}
+
+bool HeadlessContext::Create(int width, int height)
+{
+    if (!glfwInit())
+        return false;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(width, height, "Headless", NULL, NULL);
+    if (!window)
+        return false;
+    m_Context = window;
+
+    MakeCurrent();
+    // Never presents, but make sure nothing throttles to the display either
+    glfwSwapInterval(0);
+    return true;
+}
+
+bool HeadlessContext::CreateShared(const HeadlessContext& share)
+{
+    m_Owner = false;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(1, 1, "Headless shared", NULL, (GLFWwindow*)share.m_Context);
+    glfwDefaultWindowHints();
+    if (!window)
+        return false;
+    m_Context = window;
+    return true;
+}
+
+bool HeadlessContext::MakeCurrent()
+{
+    glfwMakeContextCurrent((GLFWwindow*)m_Context);
+    return true;
+}
+
+void HeadlessContext::ReleaseCurrent()
+{
+    glfwMakeContextCurrent(NULL);
+}
+
+void HeadlessContext::Destroy()
+{
+    if (m_Context) {
+        glfwDestroyWindow((GLFWwindow*)m_Context);
+        // GLFW stays initialized for the context this one shares with
+        if (m_Owner)
+            glfwTerminate();
+    }
+    m_Context = nullptr;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+/**
+* GL context without a window, for throughput testing on machines without a display.
+* Backend is picked at build time:
+*   GL_HEADLESS_EGL    - EGL, surfaceless with EGL_KHR_surfaceless_context and a 1x1 pbuffer otherwise (Mesa llvmpipe works)
+*   GL_HEADLESS_OSMESA - OSMesa software rendering
+*   neither            - hidden GLFW window, still needs a display but never presents
+* CMake picks it with GL_HEADLESS_BACKEND, the Visual Studio projects always use GLFW.
+* Rendering is expected to target a Framebuffer, there is no default framebuffer to draw to.
+**/
+class HeadlessContext
+{
+	private:
+		void* m_Display;
+		void* m_Context;
+		void* m_Config;
+		void* m_Surface;	// EGL pbuffer, only when the display can't make a context current without a surface
+		bool m_Owner;		// false for shared contexts, which leave the display and library to the one they share with
+		int m_Width;
+		int m_Height;
+		std::vector<unsigned char> m_Backbuffer; // OSMesa renders into client memory
+
+	public:
+		HeadlessContext();
+		~HeadlessContext();
+
+		HeadlessContext(const HeadlessContext&) = delete;
+		HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+		// Creates a 3.3 core context and makes it current on the calling thread
+		bool Create(int width, int height);
+
+		/**
+		* Creates a context sharing buffers, textures and programs with share, current nowhere yet: a worker thread
+		* calls MakeCurrent. Call from the thread that created share and destroy it before share.
+		**/
+		bool CreateShared(const HeadlessContext& share);
+
+		bool MakeCurrent();
+		// Detaches the context from the calling thread
+		void ReleaseCurrent();
+		void Destroy();
+
+		static const char* GetBackendName();
+
+		/**
+		* Loads the GL functions through GLEW for the context current on the calling thread
+		* Returns GLEW_OK or the GLEW error, for glewGetErrorString
+		**/
+		static unsigned int InitGLEW();
+};
@@ -1,29 +1,207 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "GLStateCache.h"
+#include "RingBuffer.h"
+#include "GpuHeap.h"
+#include "GLDeletionQueue.h"
+#include "GLCaps.h"
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) 
-    : m_Count(count)
+IndexBuffer::IndexBuffer()
+    : m_RendererID(0), m_Count(0), m_Type(IndexType::UInt32), m_Topology(PrimitiveTopology::Triangles), m_Ring(nullptr),
+    m_Heap(nullptr), m_Allocation(0), m_Offset(0), m_Overflow(0)
 {
-    ASSERT(sizeof(unsigned int) == sizeof(GLuint));
+}
+
+IndexBuffer::IndexBuffer(const PackedIndices& indices, PrimitiveTopology topology)
+    : m_Count(indices.count), m_Type(indices.type), m_Topology(topology), m_Ring(nullptr), m_Heap(nullptr), m_Allocation(0), m_Offset(0), m_Overflow(0)
+{
+    if (GLCaps::Get().directStateAccess) {
+        // Binding an element buffer would change the bound vertex array, by name it doesn't
+        GLCall(glCreateBuffers(1, &m_RendererID));
+        GLCall(glNamedBufferData(m_RendererID, indices.data.size(), indices.data.data(), GL_STATIC_DRAW));
+        return;
+    }
+
     //Generate 1 buffer, pointer to unsigned int into which to write memory
     GLCall(glGenBuffers(1, &m_RendererID));
     //select/bind buffer
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
     //Put data into buffer - type of buffer, size of buffer/data, 
-    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW)); //sends data to GPU
+    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.data.size(), indices.data.data(), GL_STATIC_DRAW)); //sends data to GPU
+}
+
+IndexBuffer::IndexBuffer(RingBuffer& ring, PrimitiveTopology topology)
+    : m_RendererID(ring.GetRendererID()), m_Count(0), m_Type(IndexType::UInt16), m_Topology(topology), m_Ring(&ring),
+    m_Heap(nullptr), m_Allocation(0), m_Offset(0), m_Overflow(0)
+{
+}
+
+IndexBuffer::IndexBuffer(GpuHeap& heap, const PackedIndices& indices, PrimitiveTopology topology)
+    : m_Count(indices.count), m_Type(indices.type), m_Topology(topology), m_Ring(nullptr), m_Heap(&heap), m_Offset(0), m_Overflow(0)
+{
+    GpuHeap::Allocation allocation = heap.Allocate((unsigned int)indices.data.size(), GetIndexSize());
+    m_RendererID = allocation.buffer;
+    m_Allocation = allocation.handle;
+    heap.Upload(m_Allocation, indices.data.data(), (unsigned int)indices.data.size());
+}
+
+IndexBuffer::IndexBuffer(IndexBuffer&& other)
+    : m_RendererID(other.m_RendererID), m_Count(other.m_Count), m_Type(other.m_Type), m_Topology(other.m_Topology),
+    m_Ring(other.m_Ring), m_Heap(other.m_Heap), m_Allocation(other.m_Allocation), m_Offset(other.m_Offset),
+    m_Overflow(other.m_Overflow)
+{
+    other.m_RendererID = 0;
+    other.m_Overflow = 0;
+    other.m_Ring = nullptr;
+    other.m_Heap = nullptr;
+}
+
+IndexBuffer& IndexBuffer::operator=(IndexBuffer&& other)
+{
+    if (this != &other) {
+        Release();
+        m_RendererID = other.m_RendererID;
+        m_Count = other.m_Count;
+        m_Type = other.m_Type;
+        m_Topology = other.m_Topology;
+        m_Ring = other.m_Ring;
+        m_Heap = other.m_Heap;
+        m_Allocation = other.m_Allocation;
+        m_Offset = other.m_Offset;
+        m_Overflow = other.m_Overflow;
+        other.m_RendererID = 0;
+        other.m_Overflow = 0;
+        other.m_Ring = nullptr;
+        other.m_Heap = nullptr;
+    }
+    return *this;
+}
+
+IndexBuffer IndexBuffer::Adopt(unsigned int rendererID, unsigned int count, IndexType type, PrimitiveTopology topology)
+{
+    IndexBuffer ib;
+    ib.m_RendererID = rendererID;
+    ib.m_Count = count;
+    ib.m_Type = type;
+    ib.m_Topology = topology;
+    return ib;
 }
 
 IndexBuffer::~IndexBuffer()
 {
-    GLCall(glDeleteBuffers(1, &m_RendererID));
+    Release();
+}
+
+void IndexBuffer::Release()
+{
+    // The ring owns the storage of streamed buffers, only the overflow buffer is ours
+    if (m_Ring) {
+        if (m_Overflow)
+            GLDeletionQueue::Get().DeleteBuffer(m_Overflow);
+        return;
+    }
+    if (m_Heap) {
+        m_Heap->Free(m_Allocation);
+        return;
+    }
+    // Draws still in flight may read the buffer, it is deleted once they retire
+    if (m_RendererID)
+        GLDeletionQueue::Get().DeleteBuffer(m_RendererID);
 }
 
 void IndexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, GetRendererID());
 }
 
 void IndexBuffer::Unbind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void IndexBuffer::Update(const PackedIndices& indices)
+{
+    m_Count = indices.count;
+    m_Type = indices.type;
+    unsigned int size = (unsigned int)indices.data.size();
+    if (m_Ring) {
+        RingBuffer::Allocation allocation = m_Ring->Write(indices.data.data(), size, GetIndexSize());
+        if (allocation.data) {
+            m_RendererID = m_Ring->GetRendererID();
+            m_Offset = allocation.offset;
+            return;
+        }
+        // The frame's region is full: orphan a buffer of our own instead, draws in flight keep the old storage
+        if (!m_Overflow) {
+            GLCall(glGenBuffers(1, &m_Overflow));
+        }
+        GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, m_Overflow);
+        GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, indices.data.data(), GL_STREAM_DRAW));
+        m_RendererID = m_Overflow;
+        m_Offset = 0;
+        return;
+    }
+    if (m_Heap) {
+        // The allocation was aligned for the original type, a wider one may not line up
+        ASSERT(m_Heap->GetOffset(m_Allocation) % GetIndexSize() == 0);
+        m_Heap->Upload(m_Allocation, indices.data.data(), size);
+        return;
+    }
+    if (GLCaps::Get().directStateAccess) {
+        GLCall(glNamedBufferData(m_RendererID, size, indices.data.data(), GL_DYNAMIC_DRAW));
+        return;
+    }
+    GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
+    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices.data.data(), GL_DYNAMIC_DRAW));
+}
+
+unsigned int IndexBuffer::GetGLType() const
+{
+    switch (m_Type) {
+        case IndexType::UInt8:  return GL_UNSIGNED_BYTE;
+        case IndexType::UInt16: return GL_UNSIGNED_SHORT;
+        default:                return GL_UNSIGNED_INT;
+    }
+}
+
+unsigned int IndexBuffer::GetGLTopology() const
+{
+    switch (m_Topology) {
+        case PrimitiveTopology::TriangleStrip: return GL_TRIANGLE_STRIP;
+        case PrimitiveTopology::TriangleFan:   return GL_TRIANGLE_FAN;
+        case PrimitiveTopology::Lines:         return GL_LINES;
+        case PrimitiveTopology::LineStrip:     return GL_LINE_STRIP;
+        case PrimitiveTopology::Points:        return GL_POINTS;
+        default:                               return GL_TRIANGLES;
+    }
+}
+
+unsigned int IndexBuffer::GetIndexSize() const
+{
+    switch (m_Type) {
+        case IndexType::UInt8:  return 1;
+        case IndexType::UInt16: return 2;
+        default:                return 4;
+    }
+}
+
+unsigned int IndexBuffer::GetRestartIndex() const
+{
+    if (!HasPrimitiveRestart())
+        return 0;
+    switch (m_Type) {
+        case IndexType::UInt8:  return 0xFF;
+        case IndexType::UInt16: return 0xFFFF;
+        default:                return 0xFFFFFFFF;
+    }
+}
+
+unsigned int IndexBuffer::GetRendererID() const
+{
+    return m_Heap ? m_Heap->GetBuffer(m_Allocation) : m_RendererID;
+}
+
+unsigned int IndexBuffer::GetOffset() const
+{
+    return m_Heap ? m_Heap->GetOffset(m_Allocation) : m_Offset;
 }
@@ -1,17 +1,164 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+class RingBuffer;
+class GpuHeap;
+
+/**
+* GL_INDEX_ALLOW_UBYTE = 1 lets meshes with fewer than 255 vertices use 8-bit indices. Off by default:
+* many GPUs have no native 8-bit index fetch and the driver widens them on the CPU.
+**/
+#ifndef GL_INDEX_ALLOW_UBYTE
+	#define GL_INDEX_ALLOW_UBYTE 0
+#endif
+
+enum class IndexType
+{
+	UInt8,
+	UInt16,
+	UInt32
+};
+
+enum class PrimitiveTopology
+{
+	Triangles,
+	TriangleStrip,
+	TriangleFan,
+	Lines,
+	LineStrip,
+	Points
+};
+
+// Strips and fans are split with primitive restart, the other topologies don't need it
+inline bool UsesPrimitiveRestart(PrimitiveTopology topology)
+{
+	return topology == PrimitiveTopology::TriangleStrip || topology == PrimitiveTopology::TriangleFan ||
+		topology == PrimitiveTopology::LineStrip;
+}
+
+// Index data converted to the type it will be drawn with
+struct PackedIndices
+{
+	std::vector<uint8_t> data;
+	IndexType type;
+	unsigned int count;
+};
+
+template<typename To, typename From>
+void ConvertIndices(const From* indices, unsigned int count, bool primitiveRestart, std::vector<uint8_t>& output)
+{
+	output.resize(count * sizeof(To));
+	To* packed = (To*)output.data();
+	for (unsigned int i = 0; i < count; i++)
+		packed[i] = (primitiveRestart && indices[i] == (From)~From(0)) ? (To)~To(0) : (To)indices[i];
+}
+
+/**
+* Picks the smallest index type holding every index and converts to it, 16-bit for anything under 65535 vertices.
+* The maximum value of each type is reserved: with primitive restart, the maximum of the source type marks
+* a restart and becomes the maximum of the packed type.
+**/
+template<typename T>
+PackedIndices PackIndices(const T* indices, unsigned int count, bool primitiveRestart)
+{
+	const T restart = (T)~T(0);
+	uint64_t maxIndex = 0;
+	for (unsigned int i = 0; i < count; i++)
+		if (!primitiveRestart || indices[i] != restart)
+			maxIndex = std::max(maxIndex, (uint64_t)indices[i]);
+
+	PackedIndices packed;
+	packed.count = count;
+#if GL_INDEX_ALLOW_UBYTE
+	if (maxIndex < 0xFF) {
+		packed.type = IndexType::UInt8;
+		ConvertIndices<uint8_t>(indices, count, primitiveRestart, packed.data);
+	}
+	else
+#endif
+	if (maxIndex < 0xFFFF) {
+		packed.type = IndexType::UInt16;
+		ConvertIndices<uint16_t>(indices, count, primitiveRestart, packed.data);
+	}
+	else {
+		packed.type = IndexType::UInt32;
+		ConvertIndices<uint32_t>(indices, count, primitiveRestart, packed.data);
+	}
+	return packed;
+}
+
 class IndexBuffer
 {
 	private:
 		unsigned int m_RendererID;
 		unsigned int m_Count;
+		IndexType m_Type;
+		PrimitiveTopology m_Topology;
+		RingBuffer* m_Ring;		// backing store of streamed buffers, null when the buffer owns its storage
+		GpuHeap* m_Heap;		// backing store of sub-allocated buffers
+		unsigned int m_Allocation;
+		unsigned int m_Offset;	// byte offset of the first index inside the GL buffer
+		unsigned int m_Overflow;	// own buffer a ring backed one streams through while the ring region is full
+
+		IndexBuffer();
+		void Release();
 
 	public:
-		IndexBuffer(const unsigned int* data, unsigned int count);
+		/**
+		* Indices of any unsigned type, stored in the smallest type that fits (see PackIndices)
+		* Strip and fan topologies enable primitive restart, mark restarts with the maximum value of T
+		**/
+		template<typename T>
+		IndexBuffer(const T* data, unsigned int count, PrimitiveTopology topology = PrimitiveTopology::Triangles)
+			: IndexBuffer(PackIndices(data, count, UsesPrimitiveRestart(topology)), topology) {}
+		IndexBuffer(const PackedIndices& indices, PrimitiveTopology topology = PrimitiveTopology::Triangles);
+		// Streamed buffer living in the ring, every Update writes a new copy into the current frame's region
+		explicit IndexBuffer(RingBuffer& ring, PrimitiveTopology topology = PrimitiveTopology::Triangles);
+		// Sub-allocated from the heap, which may hold the vertices too
+		template<typename T>
+		IndexBuffer(GpuHeap& heap, const T* data, unsigned int count, PrimitiveTopology topology = PrimitiveTopology::Triangles)
+			: IndexBuffer(heap, PackIndices(data, count, UsesPrimitiveRestart(topology)), topology) {}
+		IndexBuffer(GpuHeap& heap, const PackedIndices& indices, PrimitiveTopology topology = PrimitiveTopology::Triangles);
 		~IndexBuffer();
 
+		// Move only, a copy would delete the GL buffer twice
+		IndexBuffer(const IndexBuffer&) = delete;
+		IndexBuffer& operator=(const IndexBuffer&) = delete;
+		IndexBuffer(IndexBuffer&& other);
+		IndexBuffer& operator=(IndexBuffer&& other);
+
+		// Takes ownership of a buffer created elsewhere, e.g. by the upload thread
+		static IndexBuffer Adopt(unsigned int rendererID, unsigned int count, IndexType type,
+			PrimitiveTopology topology = PrimitiveTopology::Triangles);
+
 		void Bind() const;
 		void Unbind() const;
 
+		/**
+		* Replaces the indices, orphaning the old storage (or writing into the ring when ring backed,
+		* falling back to orphaning a buffer of its own when the frame's region is full)
+		* The index type may change, heap backed buffers can't grow past their original size in bytes
+		**/
+		template<typename T>
+		void Update(const T* data, unsigned int count) { Update(PackIndices(data, count, UsesPrimitiveRestart(m_Topology))); }
+		void Update(const PackedIndices& indices);
+
 		inline unsigned int GetCount() const { return m_Count; }
-};
\ No newline at end of file
+		inline IndexType GetType() const { return m_Type; }
+		inline PrimitiveTopology GetTopology() const { return m_Topology; }
+		inline bool HasPrimitiveRestart() const { return UsesPrimitiveRestart(m_Topology); }
+
+		// GL enums for the draw call: GL_UNSIGNED_SHORT..., GL_TRIANGLES...
+		unsigned int GetGLType() const;
+		unsigned int GetGLTopology() const;
+		unsigned int GetIndexSize() const;
+		// Maximum value of the index type, 0 when the topology doesn't restart
+		unsigned int GetRestartIndex() const;
+
+		// Heap backed buffers move when the heap is defragmented, these always return the current location
+		unsigned int GetRendererID() const;
+		unsigned int GetOffset() const;
+};
@@ -0,0 +1,84 @@
+#include "Instrumentor.h"
+#include <functional>
+#include <iomanip>
+#include <thread>
+
+Instrumentor::Instrumentor()
+    : m_Epoch(std::chrono::steady_clock::now())
+{
+}
+
+Instrumentor::~Instrumentor()
+{
+    EndSession();
+}
+
+Instrumentor& Instrumentor::Get()
+{
+    static Instrumentor instance;
+    return instance;
+}
+
+void Instrumentor::BeginSession(const std::string& name, const std::string& filepath)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_OutputStream.is_open())
+        return;
+
+    m_OutputStream.open(filepath);
+    // Timestamps run into the millions of microseconds, keep them out of scientific notation
+    m_OutputStream << std::fixed << std::setprecision(3);
+    m_OutputStream << "{\"otherData\": {\"session\": \"" << name << "\"},\"traceEvents\":[";
+    // Name the tracks so the viewer shows CPU and GPU apart
+    m_OutputStream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},";
+    m_OutputStream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << GpuTrack << ",\"args\":{\"name\":\"GPU\"}}";
+}
+
+void Instrumentor::EndSession()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_OutputStream.is_open())
+        return;
+
+    m_OutputStream << "]}";
+    m_OutputStream.close();
+}
+
+double Instrumentor::Now() const
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_Epoch).count();
+}
+
+void Instrumentor::WriteEvent(int pid, uint32_t tid, const char* name, double start, double duration)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_OutputStream.is_open())
+        return;
+
+    // The track names are always written first, so every event follows another one
+    m_OutputStream << ",{\"cat\":\"function\",\"dur\":" << duration << ",\"name\":\"" << name
+        << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"ts\":" << start << "}";
+}
+
+void Instrumentor::WriteProfile(const ProfileResult& result)
+{
+    WriteEvent(0, result.threadID, result.name, result.start, result.duration);
+}
+
+void Instrumentor::WriteGpuProfile(const ProfileResult& result)
+{
+    WriteEvent(GpuTrack, result.threadID, result.name, result.start, result.duration);
+}
+
+InstrumentationTimer::InstrumentationTimer(const char* name)
+    : m_Name(name), m_Start(Instrumentor::Get().Now())
+{
+}
+
+InstrumentationTimer::~InstrumentationTimer()
+{
+    Instrumentor& instrumentor = Instrumentor::Get();
+    double end = instrumentor.Now();
+    uint32_t threadID = (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id());
+    instrumentor.WriteProfile({ m_Name, m_Start, end - m_Start, threadID });
+}
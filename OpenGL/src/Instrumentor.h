@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+/**
+* GL_TRACE = 1 enables the PROFILE_* markers, which stream a Chrome trace JSON file
+* (load it in chrome://tracing or ui.perfetto.dev)
+**/
+#ifndef GL_TRACE
+	#define GL_TRACE 0
+#endif
+
+struct ProfileResult
+{
+	const char* name;
+	double start;		// microseconds on the trace clock
+	double duration;	// microseconds
+	uint32_t threadID;
+};
+
+/**
+* Writes trace events to the session file as they arrive, one complete ("X") event per scope.
+* CPU scopes go under process 0, GPU passes under process 1 so both show up as separate tracks.
+**/
+class Instrumentor
+{
+	public:
+		static const uint32_t GpuTrack = 1;
+
+	private:
+		std::mutex m_Mutex;
+		std::ofstream m_OutputStream;
+		std::chrono::steady_clock::time_point m_Epoch;
+
+		void WriteEvent(int pid, uint32_t tid, const char* name, double start, double duration);
+
+	public:
+		Instrumentor();
+		~Instrumentor();
+
+		static Instrumentor& Get();
+
+		void BeginSession(const std::string& name, const std::string& filepath = "profile.json");
+		void EndSession();
+
+		void WriteProfile(const ProfileResult& result);
+		void WriteGpuProfile(const ProfileResult& result);
+
+		// Microseconds since the trace clock started, the timebase of every event
+		double Now() const;
+		inline bool IsActive() const { return m_OutputStream.is_open(); }
+};
+
+class InstrumentationTimer
+{
+	private:
+		const char* m_Name;
+		double m_Start;
+
+	public:
+		InstrumentationTimer(const char* name);
+		~InstrumentationTimer();
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if GL_TRACE
+#define PROFILE_SCOPE(name) InstrumentationTimer PROFILE_CONCAT(timer, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#endif
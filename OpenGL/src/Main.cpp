@@ -4,138 +4,141 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <vector>
 
 #include "Renderer.h"
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
 #include "VertexArray.h"
+#include "GLStateCache.h"
+#include "Framebuffer.h"
+#include "GpuTimer.h"
+#include "HeadlessContext.h"
+#include "Instrumentor.h"
+#include "Shader.h"
+#include "FrameClock.h"
+#include "GLDeletionQueue.h"
 
 
 
-struct ShaderProgramSource {
-    std::string VertexSource;
-    std::string FragmentSource;
-};
-
 /**
-* Parses file containing shader code
-* return - struct containing code for each type of shader
+* Prints throughput and frame time percentiles of a headless run
+* frameTimes - duration of every frame in milliseconds, sorted in place. Exact rather than the frame clock's
+* 0.1ms bins, uncapped headless frames are often shorter than a bin.
 **/
-static ShaderProgramSource ParseShader(const std::string& filePath) {
-    std::ifstream stream(filePath); //opens file
-
-    enum class ShaderType {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
-
-    std::string line;
-    std::stringstream ss[2];
-    ShaderType type = ShaderType::NONE;
-    while (getline(stream, line)) {
-        if (line.find("#shader") != std::string::npos) { //if found #shader in that line
-            if (line.find("vertex") != std::string::npos) {
-                // set mode to vertex
-                type = ShaderType::VERTEX;
-            }
-            else if (line.find("fragment") != std::string::npos) {
-                // set mode to fragment
-                type = ShaderType::FRAGMENT;
-            }
-        }
-        else{
-            ss[(int)type] << line << '\n';
-        }        
-    }
-
-    return { ss[0].str(), ss[1].str() };
+static void PrintFrameTimeSummary(std::vector<double>& frameTimes, double totalSeconds) {
+    if (frameTimes.empty())
+        return;
+    std::sort(frameTimes.begin(), frameTimes.end());
+    auto percentile = [&](double p) { return frameTimes[(size_t)(p * (frameTimes.size() - 1))]; };
+
+    std::cout << "[Headless] " << frameTimes.size() << " frames in " << totalSeconds << "s : "
+        << frameTimes.size() / totalSeconds << " frames/sec" << std::endl;
+    std::cout << "[Headless] frame time ms : min " << frameTimes.front() << ", p50 " << percentile(0.50)
+        << ", p90 " << percentile(0.90) << ", p99 " << percentile(0.99) << ", max " << frameTimes.back() << std::endl;
 }
 
-static unsigned int CompileShader(unsigned int type, const std::string& source) {
-    GLCall(unsigned int id = glCreateShader(type));
-
-    //Requires raw string instead of std::string
-    const char* src = source.c_str(); //returns pointer to data inside of source so must exist
-    //Specifies source of shader : shader count, pointer to the actual pointer/memory address of source, length
-    GLCall(glShaderSource(id, 1, &src, NULL));
-    GLCall(glCompileShader(id));
-
-    int result;
-    //Query compiled shader - iv = integer and vector : shader id, parameter name (compile status), int parameter which is a pointer
-    GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
-
-    if (result == GL_FALSE) {
-        int length;
-        //Query error message
-        GLCall(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length));
-        char* message = (char*)_malloca(length * sizeof(char)); //allocate dynamically on stack or could use new and delete afterwards
-        GLCall(glGetShaderInfoLog(id, length, &length, message));
-
-        std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER? "vertex" : "fragment") << " shader!" << std::endl;
-        std::cout << message << std::endl;
-        GLCall(glDeleteShader(id));
-        return 0;
+int main(int argc, char** argv)
+{
+    // --headless [--frames N] [--size WxH] renders offscreen as fast as possible, then prints timings
+    // --present vsync|adaptive|unlocked picks the swap interval, --cap FPS paces frames without vsync
+    bool headless = false;
+    PresentMode presentMode = PresentMode::Vsync;
+    double frameCap = 0.0;
+    unsigned int headlessFrames = 1000;
+    int width = 640;
+    int height = 480;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            headlessFrames = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            char* separator;
+            width = (int)strtol(argv[++i], &separator, 10);
+            if (*separator == 'x')
+                height = (int)strtol(separator + 1, nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--present") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "adaptive") == 0)
+                presentMode = PresentMode::Adaptive;
+            else if (strcmp(mode, "unlocked") == 0)
+                presentMode = PresentMode::Unlocked;
+            else
+                presentMode = PresentMode::Vsync;
+        }
+        else if (strcmp(argv[i], "--cap") == 0 && i + 1 < argc) {
+            frameCap = atof(argv[++i]);
+            presentMode = PresentMode::Capped;
+        }
     }
 
-    return id;
-}
-
-/**
-* Compiles and links the shaders into a program. Returns an identifier for the compiled shader
-* vertexShader - source code of vertex shader
-* fragmentShader - source code of fragment shader
-*/
-static unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader) {
-    GLCall(unsigned int program = glCreateProgram());
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
-    
-    //Attach shaders to program - like linking the two files into one program
-    GLCall(glAttachShader(program, vs));
-    GLCall(glAttachShader(program, fs));
-    GLCall(glLinkProgram(program));
-    GLCall(glValidateProgram(program));
-
-    //Delete the "intermediates" (like objs) as they have now been linked to a program
-    GLCall(glDeleteShader(vs));
-    GLCall(glDeleteShader(fs));
-    //Technically should detach shaders, but this is a minimal optimization which also reduces debugging capability so we'll leave that out
-    //glDetachShader(program, vs);
-    //glDetachShader(program, fs);
-
-    return program;
-}
+    GLFWwindow* window = nullptr;
+    HeadlessContext headlessContext;
 
-int main(void)
-{
-    GLFWwindow* window;
+    if (headless) {
+        if (!headlessContext.Create(width, height)) {
+            std::cout << "Failed to create a headless context (" << HeadlessContext::GetBackendName() << ")" << std::endl;
+            return -1;
+        }
+        std::cout << "HEADLESS CONTEXT : " << HeadlessContext::GetBackendName() << std::endl;
+    }
+    else {
+        /* Initialize the library */
+        if (!glfwInit())
+            return -1;
+
+        // Use core profile
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); //Without this, we are using GLFW_OPENGL_COMPAT_PROFILE
+#if !GL_DEBUG_CHECKS
+        // glGetError checks are compiled out, so ask for a debug context to get KHR_debug messages instead
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
+
+
+        /* Create a windowed mode window and its OpenGL context */
+        window = glfwCreateWindow(width, height, "Hello World", NULL, NULL);
+        if (!window)
+        {
+            glfwTerminate();
+            return -1;
+        }
 
-    /* Initialize the library */
-    if (!glfwInit())
-        return -1;
-        
-    // Use core profile
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); //Without this, we are using GLFW_OPENGL_COMPAT_PROFILE
+        /* Make the window's context current */
+        glfwMakeContextCurrent(window);
 
+        presentMode = ApplyPresentMode(presentMode);
+        std::cout << "PRESENT MODE : " << GetPresentModeName(presentMode) << std::endl;
+    }
 
-    /* Create a windowed mode window and its OpenGL context */
-    window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);
-    if (!window)
+    GLenum glewError = headless ? HeadlessContext::InitGLEW() : glewInit();
+    if (glewError != GLEW_OK)
     {
-        glfwTerminate(); 
+        std::cout << "GLEW : " << glewGetErrorString(glewError) << std::endl;
         return -1;
     }
 
-    /* Make the window's context current */
-    glfwMakeContextCurrent(window);
+    // Every gl* call goes through the dispatch table from here on
+    GLDispatchLoadDriver();
 
-    glfwSwapInterval(1);
+    std::cout << "OPENGL VERSION : " << glGetString(GL_VERSION) << std::endl;
 
-    if (glewInit() != GLEW_OK)
-        std::cout << "Error!" << std::endl;
+#if GL_TRACE
+    Instrumentor::Get().BeginSession("Runtime", "profile.json");
+#endif
 
-    std::cout << "OPENGL VERSION : " << glGetString(GL_VERSION) << std::endl;
+#if !GL_DEBUG_CHECKS
+    if (!GLEnableDebugOutput())
+        std::cout << "KHR_debug not supported, GL errors will go unreported!" << std::endl;
+#endif
 
     {
         /**
@@ -170,8 +173,9 @@ int main(void)
         // WRITE OUR FIRST SHADER   
         ShaderProgramSource source = ParseShader("res/shaders/Basic.shader");
         unsigned int shader = CreateShader(source.VertexSource, source.FragmentSource);
+        GLStateCache& state = GLStateCache::Get();
         //Bind program
-        GLCall(glUseProgram(shader));
+        state.UseProgram(shader);
 
         // Use uniforms
         GLCall(int location = glGetUniformLocation(shader, "u_Color")); // get location of variable - uses same name "u_Color" as in fragment shader code
@@ -180,54 +184,155 @@ int main(void)
 
         // Unbind everything
         va.Unbind();
-        GLCall(glUseProgram(0));
-        GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
-        GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+        state.UseProgram(0);
+        state.BindBuffer(GL_ARRAY_BUFFER, 0);
+
 
+        Renderer renderer;
+
+        // Headless runs have no default framebuffer to present, they draw into their own target
+        std::unique_ptr<Framebuffer> offscreenTarget;
+        if (headless) {
+            offscreenTarget.reset(new Framebuffer(width, height));
+            offscreenTarget->Bind();
+        }
+        // Fences of the frames still in flight, headless runs wait on them instead of on vsync
+        const unsigned int maxFramesInFlight = 2;
+        GLsync frameFences[maxFramesInFlight] = {};
+        // Headless runs keep every frame for the summary, windowed ones the last few seconds
+        FrameClock frameClock(headless ? headlessFrames : 512);
+        if (!headless && presentMode == PresentMode::Capped)
+            frameClock.SetFrameCap(frameCap);
+#if GL_TRACE
+        GpuTimer gpuTimer;
+#endif
 
         float r = 0.0f;
-        float increment = 0.05f;
+        float speed = 3.0f; // red channel change per second
+        float deltaTime = 0.0f;
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point runStart = Clock::now();
+        Clock::time_point lastReportTime = runStart;
+        unsigned int frame = 0;
         /* Loop until the user closes the window */
-        while (!glfwWindowShouldClose(window))
+        while (headless ? frame < headlessFrames : !glfwWindowShouldClose(window))
         {
-            /* Render here */
-            GLCall(glClear(GL_COLOR_BUFFER_BIT));
-
-            GLCall(glUseProgram(shader));
-
-            GLCall(glUniform4f(location, r, 1.0f, 0.12f, 1.0f));
-
-            va.Bind();
-            ib.Bind();
-
-
-            /**
-            * 2- TELL OPENGL HOW THE DATA IS LAYED OUT
-            **/
-            //Draw call type 1 : Type of primitive, start index of vertices, number of vertices
-            //glDrawArrays(GL_TRIANGLES, 0, 6); //used when we don't have an index buffer; draws from the last bound buffer (step 1)
-
-            //Draw call type 2 : Type of primitive, number of vertices, type of index data
-            GLCall(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr)); //used with index buffer
+            if (headless) {
+                // Keep at most maxFramesInFlight frames queued so the GPU work is measured, not just the submission
+                GLsync& fence = frameFences[frame % maxFramesInFlight];
+                if (fence) {
+                    GLCall(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+                    GLCall(glDeleteSync(fence));
+                    fence = nullptr;
+                }
+            }
 
+#if GL_TRACE
+            gpuTimer.BeginFrame();
+#endif
+            {
+                PROFILE_SCOPE("Submit");
+                /* Render here */
+                renderer.Clear();
+
+                UniformBlock uniforms;
+                uniforms.SetFloat4(location, r, 1.0f, 0.12f, 1.0f);
+                renderer.Submit(va, ib, shader, uniforms);
+
+                /**
+                * 2- TELL OPENGL HOW THE DATA IS LAYED OUT
+                **/
+                //Draw call type 1 : Type of primitive, start index of vertices, number of vertices
+                //glDrawArrays(GL_TRIANGLES, 0, 6); //used when we don't have an index buffer; draws from the last bound buffer (step 1)
+
+                //Draw call type 2 : Type of primitive, number of vertices, type of index data - issued by the renderer for every queued draw
+                PROFILE_GPU_PASS(gpuTimer, "Main pass");
+                renderer.Flush();
+            }
 
-            if (r > 1.0f)
-                increment = -0.05f;
-            else if (r < 0.0f)
-                increment = 0.05f;
+            {
+                PROFILE_SCOPE("Update");
+                if (r > 1.0f)
+                    speed = -3.0f;
+                else if (r < 0.0f)
+                    speed = 3.0f;
 
-            r += increment;
+                r += speed * deltaTime;
+            }
 
-            /* Swap front and back buffers */
-            GLCall(glfwSwapBuffers(window));
+            if (headless) {
+                GLCall(frameFences[frame % maxFramesInFlight] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+            }
+            else {
+                {
+                    PROFILE_SCOPE("Swap");
+                    /* Swap front and back buffers */
+                    GLCall(glfwSwapBuffers(window));
+                }
+
+                /* Poll for and process events */
+                GLCall(glfwPollEvents());
+            }
 
-            /* Poll for and process events */
-            GLCall(glfwPollEvents());
+            deltaTime = (float)frameClock.Tick();
+            Clock::time_point frameEnd = Clock::now();
+            frame++;
+
+            GLDeletionQueue::Get().EndFrame();
+            GLFlushDebugMessages();
+#if GL_PROFILE_CALLS
+            GLProfiler::EndFrame();
+#endif
+#if !GL_DEBUG_CHECKS
+            unsigned int elidedChecks = GLGetElidedCheckCount();
+            GLResetElidedCheckCount();
+#endif
+            GLStateCache::Stats stateStats = state.GetFrameStats();
+            state.ResetFrameStats();
+            Renderer::Stats renderStats = renderer.GetFrameStats();
+            renderer.ResetFrameStats();
+
+            // Report once per second rather than every frame to keep the console readable
+            if (frameEnd - lastReportTime >= std::chrono::seconds(1)) {
+                lastReportTime = frameEnd;
+#if !GL_DEBUG_CHECKS
+                std::cout << "[Frame] glGetError checks compiled out : " << elidedChecks << std::endl;
+#endif
+                std::cout << "[Frame] state cache : " << stateStats.hits << " redundant binds skipped, "
+                    << stateStats.misses << " sent to the driver" << std::endl;
+                std::cout << "[Frame] renderer : " << renderStats.draws << " draws, "
+                    << renderStats.uniformUploadsSkipped << " uniform uploads skipped" << std::endl;
+                std::cout << "[Frame] frame time ms : p50 " << frameClock.GetPercentile(0.50) << ", p95 "
+                    << frameClock.GetPercentile(0.95) << ", p99 " << frameClock.GetPercentile(0.99) << std::endl;
+#if GL_PROFILE_CALLS
+                std::cout << "[Frame] GL calls :" << std::endl;
+                GLProfiler::Print(std::cout);
+#endif
+            }
         }
+        if (headless) {
+            GLCall(glFinish());
+            double totalSeconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+            std::vector<double> frameTimes = frameClock.GetFrameTimes();
+            PrintFrameTimeSummary(frameTimes, totalSeconds);
+        }
+
         //Clean up
+        for (GLsync fence : frameFences) {
+            if (fence) {
+                GLCall(glDeleteSync(fence));
+            }
+        }
         GLCall(glDeleteProgram(shader));
+        state.OnDeleteProgram(shader);
     }
-
-    glfwTerminate();
+    // Buffers and vertex arrays destroyed above are only queued, delete them while the context is alive
+    GLDeletionQueue::Get().Flush();
+
+#if GL_TRACE
+    Instrumentor::Get().EndSession();
+#endif
+    if (!headless)
+        glfwTerminate();
     return 0;
 }
\ No newline at end of file
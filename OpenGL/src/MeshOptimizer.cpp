@@ -0,0 +1,281 @@
+#include "MeshOptimizer.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const unsigned int Unused = 0xFFFFFFFF;
+
+/**
+* Triangles using each vertex, in compact form: the triangles of vertex v are
+* triangles[offsets[v]] .. triangles[offsets[v] + counts[v]]
+**/
+struct VertexAdjacency
+{
+    std::vector<unsigned int> counts;
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> triangles;
+
+    VertexAdjacency(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount)
+        : counts(vertexCount, 0), offsets(vertexCount, 0), triangles(indexCount)
+    {
+        for (unsigned int i = 0; i < indexCount; i++)
+            counts[indices[i]]++;
+        unsigned int offset = 0;
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            offsets[v] = offset;
+            offset += counts[v];
+        }
+        std::vector<unsigned int> fill(offsets);
+        for (unsigned int i = 0; i < indexCount; i++)
+            triangles[fill[indices[i]]++] = i / 3;
+    }
+};
+
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+    unsigned int cacheSize)
+{
+    // A vertex is still cached if fewer than cacheSize misses happened since it was last loaded
+    std::vector<unsigned int> loadedAt(vertexCount, 0);
+    unsigned int transforms = 0;
+    for (unsigned int i = 0; i < indexCount; i++) {
+        unsigned int& loaded = loadedAt[indices[i]];
+        if (loaded == 0 || transforms - loaded >= cacheSize)
+            loaded = ++transforms;
+    }
+
+    VertexCacheStats stats;
+    stats.transforms = transforms;
+    stats.acmr = indexCount ? (float)transforms / (indexCount / 3) : 0.0f;
+    stats.atvr = vertexCount ? (float)transforms / vertexCount : 0.0f;
+    return stats;
+}
+
+void OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, unsigned int indexCount,
+    unsigned int vertexCount, unsigned int cacheSize)
+{
+    ASSERT(indexCount % 3 == 0);
+    // Nothing to reorder, and the fanning start below reads the first vertex
+    if (indexCount == 0 || vertexCount == 0)
+        return;
+    unsigned int triangleCount = indexCount / 3;
+    VertexAdjacency adjacency(indices, indexCount, vertexCount);
+
+    // Work on a copy so destination may alias indices
+    std::vector<unsigned int> source(indices, indices + indexCount);
+    std::vector<unsigned int> liveTriangles(adjacency.counts);
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    deadEnd.reserve(indexCount);
+
+    unsigned int timestamp = cacheSize + 1;
+    unsigned int cursor = 0;	// next vertex to try once the dead end stack runs dry
+    unsigned int output = 0;
+    unsigned int fanning = 0;
+    while (fanning != Unused) {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (unsigned int i = 0; i < adjacency.counts[fanning]; i++) {
+            unsigned int triangle = adjacency.triangles[adjacency.offsets[fanning] + i];
+            if (emitted[triangle])
+                continue;
+            for (unsigned int corner = 0; corner < 3; corner++) {
+                unsigned int v = source[triangle * 3 + corner];
+                destination[output++] = v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (timestamp - cacheTime[v] > cacheSize)
+                    cacheTime[v] = timestamp++;
+            }
+            emitted[triangle] = true;
+        }
+
+        // Next fanning vertex: the candidate that stays in cache the longest once its triangles are emitted
+        fanning = Unused;
+        int best = -1;
+        for (unsigned int v : candidates) {
+            if (!liveTriangles[v])
+                continue;
+            int priority = 0;
+            if (timestamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = (int)(timestamp - cacheTime[v]);
+            if (priority > best) {
+                best = priority;
+                fanning = v;
+            }
+        }
+        if (fanning != Unused)
+            continue;
+
+        // Dead end: fall back to a recently used vertex, then to any vertex with triangles left
+        while (!deadEnd.empty() && fanning == Unused) {
+            unsigned int v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v])
+                fanning = v;
+        }
+        while (fanning == Unused && cursor < vertexCount) {
+            if (liveTriangles[cursor])
+                fanning = cursor;
+            cursor++;
+        }
+    }
+    ASSERT(output == indexCount);
+}
+
+struct TriangleCluster
+{
+    unsigned int begin;		// first triangle
+    unsigned int end;
+    float sortKey;
+};
+
+static void ReadPosition(const float* positions, unsigned int positionStride, unsigned int vertex, float* out)
+{
+    memcpy(out, (const uint8_t*)positions + (size_t)vertex * positionStride, 3 * sizeof(float));
+}
+
+void OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, unsigned int indexCount,
+    const float* positions, unsigned int vertexCount, unsigned int positionStride, float threshold, unsigned int cacheSize)
+{
+    ASSERT(indexCount % 3 == 0);
+    unsigned int triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+    std::vector<unsigned int> source(indices, indices + indexCount);
+
+    // Split into clusters: hard boundaries where a triangle misses on all three vertices (the order starts over),
+    // soft ones once a cluster's ACMR is already within the threshold of the whole mesh. Clusters can end up
+    // anywhere in the new order, so their own ACMR is measured starting from an empty cache.
+    float meshAcmr = AnalyzeVertexCache(source.data(), indexCount, vertexCount, cacheSize).acmr;
+    std::vector<TriangleCluster> clusters;
+    std::vector<unsigned int> loadedAt(vertexCount, 0);
+    std::vector<unsigned int> clusterLoadedAt(vertexCount, 0);
+    unsigned int transforms = 0;
+    unsigned int clusterTransforms = 0;
+    unsigned int clusterStart = 0;	// clusterTransforms when the current cluster began
+    unsigned int clusterBegin = 0;
+    for (unsigned int t = 0; t < triangleCount; t++) {
+        unsigned int misses = 0;
+        for (unsigned int corner = 0; corner < 3; corner++) {
+            unsigned int& loaded = loadedAt[source[t * 3 + corner]];
+            if (loaded == 0 || transforms - loaded >= cacheSize) {
+                loaded = ++transforms;
+                misses++;
+            }
+        }
+        if (misses == 3 && t > clusterBegin) {
+            clusters.push_back({ clusterBegin, t, 0.0f });
+            clusterBegin = t;
+            clusterStart = clusterTransforms;
+        }
+
+        for (unsigned int corner = 0; corner < 3; corner++) {
+            unsigned int& loaded = clusterLoadedAt[source[t * 3 + corner]];
+            if (loaded <= clusterStart || clusterTransforms - loaded >= cacheSize)
+                loaded = ++clusterTransforms;
+        }
+        if ((float)(clusterTransforms - clusterStart) / (t + 1 - clusterBegin) <= threshold * meshAcmr) {
+            clusters.push_back({ clusterBegin, t + 1, 0.0f });
+            clusterBegin = t + 1;
+            clusterStart = clusterTransforms;
+        }
+    }
+    if (clusterBegin < triangleCount)
+        clusters.push_back({ clusterBegin, triangleCount, 0.0f });
+
+    // Area weighted centroid and normal of every cluster, and of the whole mesh
+    std::vector<float> centroids(clusters.size() * 3, 0.0f);
+    std::vector<float> normals(clusters.size() * 3, 0.0f);
+    float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusters.size(); c++) {
+        float area = 0.0f;
+        for (unsigned int t = clusters[c].begin; t < clusters[c].end; t++) {
+            float p0[3], p1[3], p2[3];
+            ReadPosition(positions, positionStride, source[t * 3 + 0], p0);
+            ReadPosition(positions, positionStride, source[t * 3 + 1], p1);
+            ReadPosition(positions, positionStride, source[t * 3 + 2], p2);
+            float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; k++) {
+                centroids[c * 3 + k] += (p0[k] + p1[k] + p2[k]) / 3.0f * triangleArea;
+                normals[c * 3 + k] += n[k];
+            }
+            area += triangleArea;
+        }
+        for (int k = 0; k < 3; k++) {
+            meshCentroid[k] += centroids[c * 3 + k];
+            centroids[c * 3 + k] = area > 0.0f ? centroids[c * 3 + k] / area : 0.0f;
+        }
+        meshArea += area;
+    }
+    for (int k = 0; k < 3; k++)
+        meshCentroid[k] = meshArea > 0.0f ? meshCentroid[k] / meshArea : 0.0f;
+
+    // Clusters far out along their own normal are likely to occlude the rest, draw them first
+    for (size_t c = 0; c < clusters.size(); c++) {
+        float key = 0.0f;
+        for (int k = 0; k < 3; k++)
+            key += (centroids[c * 3 + k] - meshCentroid[k]) * normals[c * 3 + k];
+        clusters[c].sortKey = key;
+    }
+    std::stable_sort(clusters.begin(), clusters.end(),
+        [](const TriangleCluster& a, const TriangleCluster& b) { return a.sortKey > b.sortKey; });
+
+    unsigned int output = 0;
+    for (const TriangleCluster& cluster : clusters)
+        for (unsigned int i = cluster.begin * 3; i < cluster.end * 3; i++)
+            destination[output++] = source[i];
+}
+
+unsigned int OptimizeVertexFetch(void* destination, unsigned int* indices, unsigned int indexCount,
+    const void* vertices, unsigned int vertexCount, unsigned int vertexSize)
+{
+    std::vector<unsigned int> remap(vertexCount, Unused);
+    unsigned int next = 0;
+    for (unsigned int i = 0; i < indexCount; i++) {
+        unsigned int& newIndex = remap[indices[i]];
+        if (newIndex == Unused) {
+            newIndex = next++;
+            memcpy((uint8_t*)destination + (size_t)newIndex * vertexSize, (const uint8_t*)vertices + (size_t)indices[i] * vertexSize, vertexSize);
+        }
+        indices[i] = newIndex;
+    }
+    return next;
+}
+
+void MeshOptimizationReport::Print(std::ostream& stream) const
+{
+    stream << "[Mesh] ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr
+        << ", vertices " << verticesBefore << " -> " << verticesAfter << std::endl;
+}
+
+MeshOptimizationReport OptimizeMesh(MeshData& mesh, float overdrawThreshold)
+{
+    unsigned int indexCount = (unsigned int)mesh.indices.size();
+    unsigned int vertexCount = mesh.GetVertexCount();
+
+    MeshOptimizationReport report;
+    report.before = AnalyzeVertexCache(mesh.indices.data(), indexCount, vertexCount);
+    report.verticesBefore = vertexCount;
+
+    OptimizeVertexCache(mesh.indices.data(), mesh.indices.data(), indexCount, vertexCount);
+    const float* positions = (const float*)(mesh.vertices.data() + mesh.positionOffset);
+    OptimizeOverdraw(mesh.indices.data(), mesh.indices.data(), indexCount, positions, vertexCount, mesh.vertexSize, overdrawThreshold);
+
+    std::vector<uint8_t> vertices(mesh.vertices.size());
+    unsigned int usedVertices = OptimizeVertexFetch(vertices.data(), mesh.indices.data(), indexCount,
+        mesh.vertices.data(), vertexCount, mesh.vertexSize);
+    vertices.resize((size_t)usedVertices * mesh.vertexSize);
+    mesh.vertices.swap(vertices);
+
+    report.after = AnalyzeVertexCache(mesh.indices.data(), indexCount, usedVertices);
+    report.verticesAfter = usedVertices;
+    return report;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/**
+* Offline style reordering of index and vertex data, run before the data goes into IndexBuffer/VertexBuffer:
+*   OptimizeVertexCache - triangle order for post-transform cache hits (Tipsify, Sander et al. 2007)
+*   OptimizeOverdraw    - cluster order drawing outward facing parts first, within a cache budget
+*   OptimizeVertexFetch - vertex order following first use so vertex fetches stream through memory
+* Every pass works on triangle lists of 32-bit indices.
+**/
+
+struct VertexCacheStats
+{
+	unsigned int transforms;	// vertex shader invocations with a FIFO cache of the simulated size
+	float acmr;					// average cache miss ratio: transforms per triangle, 0.5 at best for big grids, 3 at worst
+	float atvr;					// average transform to vertex ratio: transforms per vertex, 1 is ideal
+};
+
+// Simulates a FIFO post-transform cache of cacheSize entries over the index buffer
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+	unsigned int cacheSize = 16);
+
+// destination may alias indices
+void OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, unsigned int indexCount,
+	unsigned int vertexCount, unsigned int cacheSize = 16);
+
+/**
+* Reorders clusters of the cache optimized triangle order to reduce overdraw. Clusters are split where the
+* order already starts over in the cache, and further where their ACMR stays within threshold times the
+* mesh's, so threshold trades cache efficiency for smaller, better sorted clusters.
+* positions - first float of the xyz position of vertex 0, then one vertex every positionStride bytes
+**/
+void OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, unsigned int indexCount,
+	const float* positions, unsigned int vertexCount, unsigned int positionStride, float threshold = 1.05f,
+	unsigned int cacheSize = 16);
+
+/**
+* Rewrites vertices in order of first use and remaps indices to match, dropping unreferenced vertices
+* Returns the new vertex count. destination must not alias vertices.
+**/
+unsigned int OptimizeVertexFetch(void* destination, unsigned int* indices, unsigned int indexCount,
+	const void* vertices, unsigned int vertexCount, unsigned int vertexSize);
+
+// Interleaved mesh going through the whole pipeline
+struct MeshData
+{
+	std::vector<uint8_t> vertices;
+	unsigned int vertexSize;
+	unsigned int positionOffset;	// byte offset of the float xyz position inside a vertex
+	std::vector<unsigned int> indices;
+
+	inline unsigned int GetVertexCount() const { return vertexSize ? (unsigned int)(vertices.size() / vertexSize) : 0; }
+};
+
+struct MeshOptimizationReport
+{
+	VertexCacheStats before;
+	VertexCacheStats after;
+	unsigned int verticesBefore;
+	unsigned int verticesAfter;
+
+	void Print(std::ostream& stream) const;
+};
+
+// Vertex cache, then overdraw, then vertex fetch, in place
+MeshOptimizationReport OptimizeMesh(MeshData& mesh, float overdrawThreshold = 1.05f);
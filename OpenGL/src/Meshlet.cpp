@@ -0,0 +1,209 @@
+#include "Meshlet.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+static void ReadPosition(const float* positions, unsigned int positionStride, unsigned int vertex, float* out)
+{
+    memcpy(out, (const uint8_t*)positions + (size_t)vertex * positionStride, 3 * sizeof(float));
+}
+
+static float DistanceSquared(const float* a, const float* b)
+{
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Ritter's bounding sphere: start from two far apart points, grow to cover the rest
+static void ComputeBoundingSphere(Meshlet& meshlet, const std::vector<unsigned int>& vertices,
+    const float* positions, unsigned int positionStride)
+{
+    float first[3], a[3], b[3], p[3];
+    ReadPosition(positions, positionStride, vertices[0], first);
+    memcpy(a, first, sizeof(a));
+    float farthest = 0.0f;
+    for (unsigned int v : vertices) {
+        ReadPosition(positions, positionStride, v, p);
+        float d = DistanceSquared(first, p);
+        if (d > farthest) {
+            farthest = d;
+            memcpy(a, p, sizeof(a));
+        }
+    }
+    memcpy(b, a, sizeof(b));
+    farthest = 0.0f;
+    for (unsigned int v : vertices) {
+        ReadPosition(positions, positionStride, v, p);
+        float d = DistanceSquared(a, p);
+        if (d > farthest) {
+            farthest = d;
+            memcpy(b, p, sizeof(b));
+        }
+    }
+
+    float* center = meshlet.center;
+    for (int k = 0; k < 3; k++)
+        center[k] = (a[k] + b[k]) * 0.5f;
+    float radius = std::sqrt(farthest) * 0.5f;
+    for (unsigned int v : vertices) {
+        ReadPosition(positions, positionStride, v, p);
+        float d = std::sqrt(DistanceSquared(center, p));
+        if (d > radius) {
+            // Move the center towards p just enough to cover both it and the old sphere
+            float grown = (radius + d) * 0.5f;
+            for (int k = 0; k < 3; k++)
+                center[k] += (p[k] - center[k]) * (grown - radius) / d;
+            radius = grown;
+        }
+    }
+    meshlet.radius = radius;
+}
+
+static void ComputeNormalCone(Meshlet& meshlet, const unsigned int* indices, const float* positions, unsigned int positionStride)
+{
+    std::vector<float> normals;
+    normals.reserve(meshlet.triangleCount * 3);
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    for (unsigned int t = 0; t < meshlet.triangleCount; t++) {
+        const unsigned int* triangle = indices + meshlet.firstIndex + t * 3;
+        float p0[3], p1[3], p2[3];
+        ReadPosition(positions, positionStride, triangle[0], p0);
+        ReadPosition(positions, positionStride, triangle[1], p1);
+        ReadPosition(positions, positionStride, triangle[2], p2);
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        // Degenerate triangles are never rasterized, they don't constrain the cone
+        if (length == 0.0f)
+            continue;
+        for (int k = 0; k < 3; k++) {
+            normals.push_back(n[k] / length);
+            axis[k] += n[k] / length;
+        }
+    }
+
+    float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    meshlet.coneCutoff = 1.0f;
+    for (int k = 0; k < 3; k++)
+        meshlet.coneAxis[k] = length > 0.0f ? axis[k] / length : 0.0f;
+    if (length == 0.0f)
+        return;
+
+    float minDot = 1.0f;
+    for (size_t i = 0; i < normals.size(); i += 3) {
+        float d = normals[i] * meshlet.coneAxis[0] + normals[i + 1] * meshlet.coneAxis[1] + normals[i + 2] * meshlet.coneAxis[2];
+        if (d < minDot)
+            minDot = d;
+    }
+    // Every triangle faces away once the view direction is within 90 degrees minus the half angle of the axis
+    if (minDot > 0.0f)
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+std::vector<Meshlet> BuildMeshlets(const unsigned int* indices, unsigned int indexCount, const float* positions,
+    unsigned int vertexCount, unsigned int positionStride, unsigned int maxVertices, unsigned int maxTriangles)
+{
+    std::vector<Meshlet> meshlets;
+    // Last meshlet each vertex was added to, plus one
+    std::vector<unsigned int> usedBy(vertexCount, 0);
+    std::vector<unsigned int> vertices;
+    vertices.reserve(maxVertices);
+
+    Meshlet current = {};
+    auto finish = [&]() {
+        if (current.triangleCount == 0)
+            return;
+        current.vertexCount = (unsigned int)vertices.size();
+        ComputeBoundingSphere(current, vertices, positions, positionStride);
+        ComputeNormalCone(current, indices, positions, positionStride);
+        meshlets.push_back(current);
+        current = {};
+        vertices.clear();
+    };
+
+    for (unsigned int i = 0; i + 2 < indexCount; i += 3) {
+        unsigned int id = (unsigned int)meshlets.size() + 1;
+        unsigned int newVertices = 0;
+        for (unsigned int corner = 0; corner < 3; corner++)
+            newVertices += usedBy[indices[i + corner]] != id;
+        if (vertices.size() + newVertices > maxVertices || current.triangleCount == maxTriangles) {
+            finish();
+            id = (unsigned int)meshlets.size() + 1;
+        }
+
+        if (current.triangleCount == 0)
+            current.firstIndex = i;
+        for (unsigned int corner = 0; corner < 3; corner++) {
+            unsigned int v = indices[i + corner];
+            if (usedBy[v] != id) {
+                usedBy[v] = id;
+                vertices.push_back(v);
+            }
+        }
+        current.triangleCount++;
+    }
+    finish();
+    return meshlets;
+}
+
+Frustum Frustum::FromMatrix(const float* m)
+{
+    // Row r of a column major matrix is m[r], m[4 + r], m[8 + r], m[12 + r]
+    Frustum frustum;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            float* plane = frustum.planes[axis * 2 + side];
+            float sign = side == 0 ? 1.0f : -1.0f;
+            for (int c = 0; c < 4; c++)
+                plane[c] = m[c * 4 + 3] + sign * m[c * 4 + axis];
+            float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+            if (length > 0.0f)
+                for (int c = 0; c < 4; c++)
+                    plane[c] /= length;
+        }
+    }
+    return frustum;
+}
+
+bool Frustum::IntersectsSphere(const float* center, float radius) const
+{
+    for (const float* plane : planes)
+        if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius)
+            return false;
+    return true;
+}
+
+MeshletCullStats CullMeshlets(const Meshlet* meshlets, unsigned int meshletCount, const Frustum& frustum,
+    const float* cameraPosition, std::vector<MeshletDrawRange>& ranges)
+{
+    MeshletCullStats stats = { 0, 0, 0, 0 };
+    size_t firstRange = ranges.size();
+    for (unsigned int i = 0; i < meshletCount; i++) {
+        const Meshlet& meshlet = meshlets[i];
+        if (!frustum.IntersectsSphere(meshlet.center, meshlet.radius)) {
+            stats.frustumCulled++;
+            continue;
+        }
+
+        // Conservative cone test: widen the cutoff by the angle the sphere spans from the camera
+        float view[3] = { meshlet.center[0] - cameraPosition[0], meshlet.center[1] - cameraPosition[1], meshlet.center[2] - cameraPosition[2] };
+        float distance = std::sqrt(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]);
+        if (distance > meshlet.radius) {
+            float d = (view[0] * meshlet.coneAxis[0] + view[1] * meshlet.coneAxis[1] + view[2] * meshlet.coneAxis[2]) / distance;
+            if (d > meshlet.coneCutoff + meshlet.radius / distance) {
+                stats.backfaceCulled++;
+                continue;
+            }
+        }
+
+        stats.visible++;
+        stats.visibleTriangles += meshlet.triangleCount;
+        unsigned int indexCount = meshlet.triangleCount * 3;
+        if (ranges.size() > firstRange && ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex)
+            ranges.back().indexCount += indexCount;
+        else
+            ranges.push_back({ meshlet.firstIndex, indexCount });
+    }
+    return stats;
+}
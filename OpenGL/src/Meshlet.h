@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+/**
+* A run of triangles in a shared index buffer, small enough to be culled as one unit.
+* Bounds are in the space of the positions the meshlets were built from.
+**/
+struct Meshlet
+{
+	unsigned int firstIndex;
+	unsigned int triangleCount;
+	unsigned int vertexCount;	// unique vertices referenced
+	float center[3];
+	float radius;
+	float coneAxis[3];			// average facing of the triangles
+	float coneCutoff;			// sine of the cone's half angle, 1 when the normals spread too far to ever cull
+};
+
+/**
+* Splits an index buffer into meshlets of at most maxVertices unique vertices and maxTriangles triangles.
+* Triangles keep their order so every meshlet is a contiguous range of the same index buffer, run OptimizeMesh
+* first so that consecutive triangles are neighbours and the meshlets come out compact.
+* positions - first float of the xyz position of vertex 0, then one vertex every positionStride bytes
+**/
+std::vector<Meshlet> BuildMeshlets(const unsigned int* indices, unsigned int indexCount, const float* positions,
+	unsigned int vertexCount, unsigned int positionStride, unsigned int maxVertices = 64, unsigned int maxTriangles = 124);
+
+struct Frustum
+{
+	float planes[6][4];		// xyz normal pointing inside, w distance
+
+	// Gribb/Hartmann extraction from a column major projection * view (* model) matrix
+	static Frustum FromMatrix(const float* matrix);
+
+	bool IntersectsSphere(const float* center, float radius) const;
+};
+
+struct MeshletDrawRange
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+};
+
+struct MeshletCullStats
+{
+	unsigned int visible;
+	unsigned int frustumCulled;
+	unsigned int backfaceCulled;
+	unsigned int visibleTriangles;
+};
+
+/**
+* Appends the index ranges of the meshlets that survive frustum and normal cone culling to ranges,
+* merging neighbours so a mostly visible mesh still goes out in a few draws.
+* frustum and cameraPosition must be in the same space as the meshlet bounds.
+**/
+MeshletCullStats CullMeshlets(const Meshlet* meshlets, unsigned int meshletCount, const Frustum& frustum,
+	const float* cameraPosition, std::vector<MeshletDrawRange>& ranges);
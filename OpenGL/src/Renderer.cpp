@@ -1,5 +1,14 @@
 #include "Renderer.h"
+#include "CommandList.h"
+#include "GLStateCache.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
 
 
 void GLClearError() {
@@ -14,4 +23,292 @@ bool GLLogCall(const char* function, const char* file, int line) {
         return false;
     }
     return true;
-}
\ No newline at end of file
+}
+
+std::atomic<const GLCallSite*> g_GLLastCallSite(nullptr);
+thread_local unsigned int g_GLElidedChecks = 0;
+
+#ifndef GL_DISPATCH_NULL_ONLY
+struct GLDebugMessage {
+    GLenum source;
+    GLenum type;
+    GLuint id;
+    GLenum severity;
+    std::string message;
+    const GLCallSite* site;
+};
+
+static std::mutex s_DebugMessageMutex;
+static std::vector<GLDebugMessage> s_DebugMessages;
+
+/**
+* Called by the driver, possibly from one of its own threads and long after the offending call when output is asynchronous.
+* Only queues the message; printing happens on the render thread in GLFlushDebugMessages.
+**/
+static void GLAPIENTRY GLDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+    GLsizei length, const GLchar* message, const void* userParam) {
+    // Notifications are informational (buffer placement, shader recompiles...) and would flood the queue
+    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+        return;
+
+    std::lock_guard<std::mutex> lock(s_DebugMessageMutex);
+    s_DebugMessages.push_back({ source, type, id, severity,
+        length < 0 ? std::string(message) : std::string(message, length),
+        g_GLLastCallSite.load(std::memory_order_relaxed) });
+}
+
+static const char* GLDebugSeverityName(GLenum severity) {
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH: return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_LOW: return "low";
+    }
+    return "notification";
+}
+#endif
+
+bool GLEnableDebugOutput(bool synchronous) {
+#ifdef GL_DISPATCH_NULL_ONLY
+    // No driver, nothing would ever be reported
+    return false;
+#else
+    if (!GLEW_KHR_debug && !GLEW_VERSION_4_3)
+        return false;
+
+    GLCall(glEnable(GL_DEBUG_OUTPUT));
+    if (synchronous) {
+        GLCall(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    }
+    else {
+        GLCall(glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    }
+    GLCall(glDebugMessageCallback(GLDebugCallback, nullptr));
+    return true;
+#endif
+}
+
+unsigned int GLFlushDebugMessages() {
+#ifdef GL_DISPATCH_NULL_ONLY
+    return 0;
+#else
+    std::vector<GLDebugMessage> messages;
+    {
+        std::lock_guard<std::mutex> lock(s_DebugMessageMutex);
+        messages.swap(s_DebugMessages);
+    }
+
+    for (const GLDebugMessage& msg : messages) {
+        std::cout << "[OpenGL Debug](" << msg.id << ", " << GLDebugSeverityName(msg.severity) << ") :" << msg.message;
+        // With asynchronous output this is the last call issued before the message arrived, not necessarily the culprit
+        if (msg.site)
+            std::cout << " after " << msg.site->function << " " << msg.site->file << ":" << msg.site->line;
+        std::cout << std::endl;
+    }
+    return (unsigned int)messages.size();
+#endif
+}
+
+unsigned int GLGetElidedCheckCount() {
+    return g_GLElidedChecks;
+}
+
+void GLResetElidedCheckCount() {
+    g_GLElidedChecks = 0;
+}
+
+void UniformBlock::SetFloat(int location, float x) {
+    ASSERT(count < MaxUniforms);
+    Value& value = values[count++];
+    value.location = location;
+    value.type = Type::Float;
+    value.data.f[0] = x;
+}
+
+void UniformBlock::SetFloat4(int location, float x, float y, float z, float w) {
+    ASSERT(count < MaxUniforms);
+    Value& value = values[count++];
+    value.location = location;
+    value.type = Type::Float4;
+    value.data.f[0] = x;
+    value.data.f[1] = y;
+    value.data.f[2] = z;
+    value.data.f[3] = w;
+}
+
+void UniformBlock::SetInt(int location, int x) {
+    ASSERT(count < MaxUniforms);
+    Value& value = values[count++];
+    value.location = location;
+    value.type = Type::Int;
+    value.data.i = x;
+}
+
+void UniformBlock::Apply() const {
+    for (unsigned int i = 0; i < count; i++) {
+        const Value& value = values[i];
+        switch (value.type) {
+            case Type::Float: GLCall(glUniform1f(value.location, value.data.f[0])); break;
+            case Type::Float4: GLCall(glUniform4f(value.location, value.data.f[0], value.data.f[1], value.data.f[2], value.data.f[3])); break;
+            case Type::Int: GLCall(glUniform1i(value.location, value.data.i)); break;
+        }
+    }
+}
+
+bool UniformBlock::operator==(const UniformBlock& other) const {
+    if (count != other.count)
+        return false;
+    for (unsigned int i = 0; i < count; i++) {
+        const Value& a = values[i];
+        const Value& b = other.values[i];
+        if (a.location != b.location || a.type != b.type)
+            return false;
+        // Only compare the components the type uses, the rest is left uninitialized
+        unsigned int components = a.type == Type::Float4 ? 4 : 1;
+        if (memcmp(&a.data, &b.data, components * sizeof(float)) != 0)
+            return false;
+    }
+    return true;
+}
+
+Renderer::Renderer()
+    : m_Stats{ 0, 0 }
+{
+}
+
+void Renderer::Clear() const {
+    GLCall(glClear(GL_COLOR_BUFFER_BIT));
+}
+
+uint64_t Renderer::MakeSortKey(RenderPass pass, unsigned int program, unsigned int vertexArray, unsigned int texture, float depth) {
+    const uint64_t idMask = 0xFFF;
+    const uint64_t depthMax = 0xFFFFFF;
+
+    if (depth < 0.0f) depth = 0.0f;
+    if (depth > 1.0f) depth = 1.0f;
+    uint64_t quantizedDepth = (uint64_t)(depth * depthMax);
+
+    uint64_t key = (uint64_t)pass << 60;
+    if (pass == RenderPass::Transparent) {
+        // Blending needs back to front, so depth wins over state
+        key |= (depthMax - quantizedDepth) << 36;
+        key |= (program & idMask) << 24;
+        key |= (vertexArray & idMask) << 12;
+        key |= (texture & idMask);
+    }
+    else {
+        key |= (program & idMask) << 48;
+        key |= (vertexArray & idMask) << 36;
+        key |= (texture & idMask) << 24;
+        key |= quantizedDepth;
+    }
+    return key;
+}
+
+void Renderer::Submit(const VertexArray& va, const IndexBuffer& ib, unsigned int program, const UniformBlock& uniforms,
+    RenderPass pass, float depth, unsigned int texture) {
+    m_SortEntries.push_back({ MakeSortKey(pass, program, va.GetRendererID(), texture, depth), (unsigned int)m_Commands.size() });
+    m_Commands.push_back({ &va, nullptr, &ib, program, texture, 0, ib.GetCount(), 1, uniforms });
+}
+
+void Renderer::SubmitInstanced(const VertexArray& va, const IndexBuffer& ib, unsigned int instanceCount, unsigned int program,
+    const UniformBlock& uniforms, RenderPass pass, float depth, unsigned int texture) {
+    m_SortEntries.push_back({ MakeSortKey(pass, program, va.GetRendererID(), texture, depth), (unsigned int)m_Commands.size() });
+    m_Commands.push_back({ &va, nullptr, &ib, program, texture, 0, ib.GetCount(), instanceCount, uniforms });
+}
+
+void Renderer::Submit(const VertexArray& format, const VertexBuffer& vb, const IndexBuffer& ib, unsigned int program,
+    const UniformBlock& uniforms, RenderPass pass, float depth, unsigned int texture) {
+    m_SortEntries.push_back({ MakeSortKey(pass, program, format.GetRendererID(), texture, depth), (unsigned int)m_Commands.size() });
+    m_Commands.push_back({ &format, &vb, &ib, program, texture, 0, ib.GetCount(), 1, uniforms });
+}
+
+void Renderer::SubmitRange(const VertexArray& va, const IndexBuffer& ib, unsigned int firstIndex, unsigned int indexCount,
+    unsigned int program, const UniformBlock& uniforms, RenderPass pass, float depth, unsigned int texture) {
+    ASSERT(firstIndex + indexCount <= ib.GetCount());
+    m_SortEntries.push_back({ MakeSortKey(pass, program, va.GetRendererID(), texture, depth), (unsigned int)m_Commands.size() });
+    m_Commands.push_back({ &va, nullptr, &ib, program, texture, firstIndex, indexCount, 1, uniforms });
+}
+
+/**
+* LSD radix sort on the 64-bit keys, one byte per pass.
+* Passes where every key has the same byte are skipped, which is most of them since ids are small.
+**/
+void Renderer::SortQueue() {
+    const size_t count = m_SortEntries.size();
+    m_SortScratch.resize(count);
+
+    SortEntry* src = m_SortEntries.data();
+    SortEntry* dst = m_SortScratch.data();
+    for (unsigned int shift = 0; shift < 64; shift += 8) {
+        size_t offsets[256] = {};
+        for (size_t i = 0; i < count; i++)
+            offsets[(src[i].key >> shift) & 0xFF]++;
+
+        if (offsets[(src[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        size_t sum = 0;
+        for (size_t& offset : offsets) {
+            size_t bucket = offset;
+            offset = sum;
+            sum += bucket;
+        }
+        for (size_t i = 0; i < count; i++)
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+        SortEntry* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != m_SortEntries.data())
+        m_SortEntries.swap(m_SortScratch);
+}
+
+void Renderer::Flush() {
+    if (!m_SortEntries.empty())
+        SortQueue();
+
+    GLStateCache& state = GLStateCache::Get();
+    const UniformBlock* lastUniforms = nullptr;
+    unsigned int lastProgram = 0;
+    for (const SortEntry& entry : m_SortEntries) {
+        const DrawCommand& cmd = m_Commands[entry.command];
+
+        state.UseProgram(cmd.program);
+        cmd.va->Bind();
+        int baseVertex = cmd.vb ? cmd.va->BindVertexBuffer(*cmd.vb) : cmd.va->GetBaseVertex();
+        cmd.ib->Bind();
+        if (cmd.texture)
+            state.BindTexture(0, GL_TEXTURE_2D, cmd.texture);
+
+        // Uniforms are program state, identical values on the same program don't need uploading again
+        if (lastUniforms && lastProgram == cmd.program && *lastUniforms == cmd.uniforms)
+            m_Stats.uniformUploadsSkipped++;
+        else
+            cmd.uniforms.Apply();
+        lastUniforms = &cmd.uniforms;
+        lastProgram = cmd.program;
+
+        state.SetPrimitiveRestart(cmd.ib->GetRestartIndex());
+        const void* indices = (const void*)(uintptr_t)(cmd.ib->GetOffset() + cmd.firstIndex * cmd.ib->GetIndexSize());
+        if (cmd.instanceCount == 1) {
+            GLCall(glDrawElementsBaseVertex(cmd.ib->GetGLTopology(), cmd.indexCount, cmd.ib->GetGLType(), (void*)indices, baseVertex));
+        }
+        else {
+            GLCall(glDrawElementsInstancedBaseVertex(cmd.ib->GetGLTopology(), cmd.indexCount, cmd.ib->GetGLType(), indices,
+                cmd.instanceCount, baseVertex));
+        }
+        m_Stats.draws++;
+    }
+
+    m_Commands.clear();
+    m_SortEntries.clear();
+}
+
+void Renderer::Execute(const CommandList* lists, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        lists[i].Execute();
+        m_Stats.draws += lists[i].GetDrawCount();
+    }
+}
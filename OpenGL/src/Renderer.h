@@ -1,13 +1,219 @@
 #pragma once
 
 #include <GL/glew.h>
+#include "GLDispatch.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
-#define ASSERT(x) if(!(x)) __debugbreak(); //specific to MSVC
+/**
+* GL_DEBUG_CHECKS selects how GL errors are caught:
+* 1 - every GLCall is wrapped in glGetError() checks (default in Debug, can force a CPU/GPU sync per call)
+* 0 - the checks are compiled out and errors are reported through the KHR_debug message callback instead
+**/
+#ifndef GL_DEBUG_CHECKS
+	#ifdef _DEBUG
+		#define GL_DEBUG_CHECKS 1
+	#else
+		#define GL_DEBUG_CHECKS 0
+	#endif
+#endif
+
+/**
+* GL_PROFILE_CALLS = 1 makes every GLCall count its calls and CPU time per GL entry point, see GLProfiler
+**/
+#ifndef GL_PROFILE_CALLS
+	#define GL_PROFILE_CALLS 0
+#endif
+
+// Breaks into the debugger, or kills the process when none is attached
+#ifdef _MSC_VER
+	#define ASSERT(x) if(!(x)) __debugbreak();
+#else
+	#define ASSERT(x) if(!(x)) __builtin_trap();
+#endif
+
+#if GL_PROFILE_CALLS
+#include "GLProfiler.h"
+#define GL_PROFILE_BEGIN() GLProfiler::BeginCall()
+#define GL_PROFILE_END(x) GLProfiler::EndCall([]() { static const unsigned int site = GLProfiler::RegisterSite(x); return site; }())
+#else
+#define GL_PROFILE_BEGIN()
+#define GL_PROFILE_END(x)
+#endif
+
+#if GL_DEBUG_CHECKS
 #define GLCall(x) GLClearError();\
+    GL_PROFILE_BEGIN();\
     x;\
+    GL_PROFILE_END(#x);\
     ASSERT(GLLogCall(#x, __FILE__, __LINE__))
-
+#else
+// Only remembers the call site (one pointer store) so the debug callback can attribute errors to it
+#define GLCall(x) GLMarkCallSite([]() -> const GLCallSite* { static const GLCallSite site = { #x, __FILE__, __LINE__ }; return &site; }());\
+    GL_PROFILE_BEGIN();\
+    x;\
+    GL_PROFILE_END(#x)
+#endif
 
 void GLClearError();
 
-bool GLLogCall(const char* function, const char* file, int line);
\ No newline at end of file
+bool GLLogCall(const char* function, const char* file, int line);
+
+struct GLCallSite
+{
+	const char* function;
+	const char* file;
+	int line;
+};
+
+extern std::atomic<const GLCallSite*> g_GLLastCallSite;
+extern thread_local unsigned int g_GLElidedChecks;
+
+inline void GLMarkCallSite(const GLCallSite* site)
+{
+	g_GLLastCallSite.store(site, std::memory_order_relaxed);
+	g_GLElidedChecks++;
+}
+
+/**
+* Registers the KHR_debug message callback. Messages are queued and printed by GLFlushDebugMessages.
+* synchronous - makes the driver report inside the failing call so the attributed call site is exact
+* return - false if the context does not support KHR_debug
+**/
+bool GLEnableDebugOutput(bool synchronous = false);
+
+/**
+* Prints and clears every debug message queued since the last flush
+* return - number of messages printed
+**/
+unsigned int GLFlushDebugMessages();
+
+// Number of glGetError checks compiled out of the GLCalls made on this thread since the last reset
+unsigned int GLGetElidedCheckCount();
+void GLResetElidedCheckCount();
+
+class VertexArray;
+class VertexBuffer;
+class IndexBuffer;
+class CommandList;
+
+/**
+* Uniform values set right before a draw. Small and copyable so it can live in the draw queue.
+**/
+struct UniformBlock
+{
+	static const unsigned int MaxUniforms = 4;
+
+	enum class Type : unsigned char { Float, Float4, Int };
+
+	struct Value
+	{
+		int location;
+		Type type;
+		union { float f[4]; int i; } data;
+	};
+
+	Value values[MaxUniforms];
+	unsigned int count = 0;
+
+	void SetFloat(int location, float x);
+	void SetFloat4(int location, float x, float y, float z, float w);
+	void SetInt(int location, int x);
+
+	// Uploads every value to the program currently in use
+	void Apply() const;
+
+	bool operator==(const UniformBlock& other) const;
+};
+
+enum class RenderPass : unsigned char
+{
+	Opaque = 0,		// sorted by state, then front to back
+	Transparent = 1	// sorted back to front, then by state
+};
+
+class Renderer
+{
+	public:
+		struct Stats
+		{
+			unsigned int draws;
+			unsigned int uniformUploadsSkipped;
+		};
+
+	private:
+		struct DrawCommand
+		{
+			const VertexArray* va;
+			const VertexBuffer* vb;	// attached to va at draw time, null when va already reads its buffer
+			const IndexBuffer* ib;
+			unsigned int program;
+			unsigned int texture;
+			unsigned int firstIndex;
+			unsigned int indexCount;
+			unsigned int instanceCount;
+			UniformBlock uniforms;
+		};
+
+		struct SortEntry
+		{
+			uint64_t key;
+			unsigned int command;
+		};
+
+		std::vector<DrawCommand> m_Commands;
+		std::vector<SortEntry> m_SortEntries;
+		std::vector<SortEntry> m_SortScratch;
+		Stats m_Stats;
+
+		void SortQueue();
+
+	public:
+		Renderer();
+
+		void Clear() const;
+
+		/**
+		* Queues a draw for the next Flush
+		* depth - view depth normalized to [0, 1], used to order draws inside a pass
+		* texture - 2D texture bound to unit 0, 0 for none
+		**/
+		void Submit(const VertexArray& va, const IndexBuffer& ib, unsigned int program, const UniformBlock& uniforms,
+			RenderPass pass = RenderPass::Opaque, float depth = 0.0f, unsigned int texture = 0);
+
+		/**
+		* Queues a draw of vb through a vertex array holding only the format (VertexArrayCache::GetFormat).
+		* Draws sharing the format sort next to each other and switching between them rebinds just the buffer.
+		**/
+		void Submit(const VertexArray& format, const VertexBuffer& vb, const IndexBuffer& ib, unsigned int program,
+			const UniformBlock& uniforms, RenderPass pass = RenderPass::Opaque, float depth = 0.0f, unsigned int texture = 0);
+
+		/**
+		* Queues instanceCount copies of the mesh in a single draw, per-instance data comes from the buffer
+		* attached to va with an instanced layout (VertexBufferLayout::PushInstanced)
+		**/
+		void SubmitInstanced(const VertexArray& va, const IndexBuffer& ib, unsigned int instanceCount, unsigned int program,
+			const UniformBlock& uniforms, RenderPass pass = RenderPass::Opaque, float depth = 0.0f, unsigned int texture = 0);
+
+		// Queues a draw of indexCount indices starting at firstIndex, e.g. the visible meshlets of a mesh
+		void SubmitRange(const VertexArray& va, const IndexBuffer& ib, unsigned int firstIndex, unsigned int indexCount,
+			unsigned int program, const UniformBlock& uniforms, RenderPass pass = RenderPass::Opaque, float depth = 0.0f,
+			unsigned int texture = 0);
+
+		// Sorts the queued draws by key and issues them, changing only the state that differs between neighbours
+		void Flush();
+
+		// Replays command lists recorded on any thread, in array order. GL thread only.
+		void Execute(const CommandList* lists, unsigned int count);
+
+		/**
+		* Packs the draw state into a 64-bit key (ids are truncated to 12 bits, depth quantized to 24 bits)
+		* Opaque      : pass 4 | program 12 | vertex array 12 | texture 12 | depth 24
+		* Transparent : pass 4 | inverted depth 24 | program 12 | vertex array 12 | texture 12
+		**/
+		static uint64_t MakeSortKey(RenderPass pass, unsigned int program, unsigned int vertexArray, unsigned int texture, float depth);
+
+		inline const Stats& GetFrameStats() const { return m_Stats; }
+		inline void ResetFrameStats() { m_Stats = { 0, 0 }; }
+};
@@ -0,0 +1,103 @@
+#include "RingBuffer.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "GLDeletionQueue.h"
+#include <cstring>
+
+RingBuffer::RingBuffer(unsigned int regionSize)
+    : m_RegionSize(regionSize), m_Mapping(nullptr), m_Mapped(false), m_Region(0), m_Head(0), m_Fences(), m_Stalls(0), m_Overflows(0)
+{
+    unsigned int totalSize = regionSize * RegionCount;
+    GLCall(glGenBuffers(1, &m_RendererID));
+    // Buffers are typeless, the copy target keeps the array and element bindings of the current VAO untouched
+    GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+#ifdef GL_DISPATCH_NULL_ONLY
+    const bool bufferStorage = false;	// no GLEW to ask, mapping per allocation works on the null table as well
+#else
+    const bool bufferStorage = GLEW_ARB_buffer_storage;
+#endif
+    if (bufferStorage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLCall(glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, nullptr, flags));
+        GLCall(m_Mapping = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags));
+    }
+    else {
+        GLCall(glBufferData(GL_COPY_WRITE_BUFFER, totalSize, nullptr, GL_STREAM_DRAW));
+    }
+}
+
+RingBuffer::~RingBuffer()
+{
+    for (GLsync fence : m_Fences) {
+        if (fence) {
+            GLCall(glDeleteSync(fence));
+        }
+    }
+    // Draws of the last frames may still read it, deleting the buffer once they retire also unmaps it
+    GLDeletionQueue::Get().DeleteBuffer(m_RendererID);
+}
+
+RingBuffer::Allocation RingBuffer::Allocate(unsigned int size, unsigned int alignment)
+{
+    ASSERT(!m_Mapped);
+    unsigned int regionStart = m_Region * m_RegionSize;
+    unsigned int offset = (regionStart + m_Head + alignment - 1) / alignment * alignment;
+    // Region too small for this frame's worth of data, the caller has to put it elsewhere
+    if (offset + size > regionStart + m_RegionSize) {
+        m_Overflows++;
+        return { nullptr, 0, 0 };
+    }
+    m_Head = offset + size - regionStart;
+
+    if (m_Mapping)
+        return { m_Mapping + offset, offset, size };
+
+    // The fence already guarantees the GPU is done with this range, no need for the driver to synchronize
+    GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+    void* data;
+    GLCall(data = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, access));
+    m_Mapped = true;
+    return { data, offset, size };
+}
+
+void RingBuffer::Commit(const Allocation& allocation)
+{
+    // Coherent persistent mappings are visible to the GPU as soon as they are written
+    if (!m_Mapped)
+        return;
+    GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+    GLCall(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+    m_Mapped = false;
+}
+
+RingBuffer::Allocation RingBuffer::Write(const void* data, unsigned int size, unsigned int alignment)
+{
+    Allocation allocation = Allocate(size, alignment);
+    if (allocation.data) {
+        memcpy(allocation.data, data, size);
+        Commit(allocation);
+    }
+    return allocation;
+}
+
+void RingBuffer::EndFrame()
+{
+    ASSERT(!m_Mapped);
+    GLCall(m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    m_Region = (m_Region + 1) % RegionCount;
+    m_Head = 0;
+    GLsync& fence = m_Fences[m_Region];
+    if (!fence)
+        return;
+
+    GLenum status;
+    GLCall(status = glClientWaitSync(fence, 0, 0));
+    if (status == GL_TIMEOUT_EXPIRED) {
+        m_Stalls++;
+        GLCall(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+    }
+    GLCall(glDeleteSync(fence));
+    fence = nullptr;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+struct __GLsync;
+
+/**
+* Per-frame streaming memory for vertices, indices and uniforms, carved out of a single GL buffer.
+* The buffer is split into RegionCount regions written one frame at a time, each guarded by a fence so
+* a region is only reused once the GPU is done with the frame that last read it.
+* With ARB_buffer_storage the whole buffer stays persistently and coherently mapped, otherwise every
+* allocation is mapped on its own with GL_MAP_UNSYNCHRONIZED_BIT and must be committed before drawing.
+**/
+class RingBuffer
+{
+	public:
+		static const unsigned int RegionCount = 3;
+
+		struct Allocation
+		{
+			void* data;				// CPU address to write to, null if the region was full
+			unsigned int offset;	// byte offset inside the GL buffer
+			unsigned int size;
+		};
+
+	private:
+		unsigned int m_RendererID;
+		unsigned int m_RegionSize;
+		unsigned char* m_Mapping;	// whole buffer when persistently mapped, null otherwise
+		bool m_Mapped;				// an unsynchronized range is mapped and not committed yet
+		unsigned int m_Region;
+		unsigned int m_Head;		// bytes used in the current region
+		__GLsync* m_Fences[RegionCount];
+		unsigned int m_Stalls;
+		unsigned int m_Overflows;
+
+	public:
+		explicit RingBuffer(unsigned int regionSize);
+		~RingBuffer();
+
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator=(const RingBuffer&) = delete;
+
+		/**
+		* Reserves size bytes in the current frame's region, offset aligned to a multiple of alignment
+		* (use GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform blocks)
+		* Returns a null allocation when the region is full, nothing is reserved then
+		**/
+		Allocation Allocate(unsigned int size, unsigned int alignment = 4);
+
+		// Makes the written allocation visible to GL, required before drawing from it
+		void Commit(const Allocation& allocation);
+
+		// Allocate, copy and commit in one go
+		Allocation Write(const void* data, unsigned int size, unsigned int alignment = 4);
+
+		// Fences this frame's region and moves to the next one, waiting if the GPU still reads it
+		void EndFrame();
+
+		inline unsigned int GetRendererID() const { return m_RendererID; }
+		inline bool IsPersistent() const { return m_Mapping != nullptr; }
+		inline unsigned int GetRegionSize() const { return m_RegionSize; }
+		inline unsigned int GetUsed() const { return m_Head; }
+		// Frames that had to wait for the GPU to release their region
+		inline unsigned int GetStalls() const { return m_Stalls; }
+		// Allocations that didn't fit their frame's region, a sign the regions are too small
+		inline unsigned int GetOverflows() const { return m_Overflows; }
+};
@@ -0,0 +1,94 @@
+#include "Shader.h"
+#include "Renderer.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+/**
+* Parses file containing shader code
+* return - struct containing code for each type of shader
+**/
+ShaderProgramSource ParseShader(const std::string& filePath) {
+    std::ifstream stream(filePath); //opens file
+
+    enum class ShaderType {
+        NONE = -1, VERTEX = 0, FRAGMENT = 1
+    };
+
+    std::string line;
+    std::stringstream ss[2];
+    ShaderType type = ShaderType::NONE;
+    while (getline(stream, line)) {
+        if (line.find("#shader") != std::string::npos) { //if found #shader in that line
+            if (line.find("vertex") != std::string::npos) {
+                // set mode to vertex
+                type = ShaderType::VERTEX;
+            }
+            else if (line.find("fragment") != std::string::npos) {
+                // set mode to fragment
+                type = ShaderType::FRAGMENT;
+            }
+        }
+        else{
+            ss[(int)type] << line << '\n';
+        }        
+    }
+
+    return { ss[0].str(), ss[1].str() };
+}
+
+unsigned int CompileShader(unsigned int type, const std::string& source) {
+    GLCall(unsigned int id = glCreateShader(type));
+
+    //Requires raw string instead of std::string
+    const char* src = source.c_str(); //returns pointer to data inside of source so must exist
+    //Specifies source of shader : shader count, pointer to the actual pointer/memory address of source, length
+    GLCall(glShaderSource(id, 1, &src, NULL));
+    GLCall(glCompileShader(id));
+
+    int result;
+    //Query compiled shader - iv = integer and vector : shader id, parameter name (compile status), int parameter which is a pointer
+    GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
+
+    if (result == GL_FALSE) {
+        int length;
+        //Query error message
+        GLCall(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length));
+        std::vector<char> message(length + 1, '\0'); //the log can be long, keep it off the stack
+        GLCall(glGetShaderInfoLog(id, length, &length, message.data()));
+
+        std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER? "vertex" : "fragment") << " shader!" << std::endl;
+        std::cout << message.data() << std::endl;
+        GLCall(glDeleteShader(id));
+        return 0;
+    }
+
+    return id;
+}
+
+/**
+* Compiles and links the shaders into a program. Returns an identifier for the compiled shader
+* vertexShader - source code of vertex shader
+* fragmentShader - source code of fragment shader
+*/
+unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader) {
+    GLCall(unsigned int program = glCreateProgram());
+    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
+    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    
+    //Attach shaders to program - like linking the two files into one program
+    GLCall(glAttachShader(program, vs));
+    GLCall(glAttachShader(program, fs));
+    GLCall(glLinkProgram(program));
+    GLCall(glValidateProgram(program));
+
+    //Delete the "intermediates" (like objs) as they have now been linked to a program
+    GLCall(glDeleteShader(vs));
+    GLCall(glDeleteShader(fs));
+    //Technically should detach shaders, but this is a minimal optimization which also reduces debugging capability so we'll leave that out
+    //glDetachShader(program, vs);
+    //glDetachShader(program, fs);
+
+    return program;
+}
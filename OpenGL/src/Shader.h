@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+struct ShaderProgramSource {
+    std::string VertexSource;
+    std::string FragmentSource;
+};
+
+ShaderProgramSource ParseShader(const std::string& filePath);
+
+// Compiles a single shader stage, returns 0 and prints the info log on failure
+unsigned int CompileShader(unsigned int type, const std::string& source);
+
+unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
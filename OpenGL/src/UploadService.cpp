@@ -0,0 +1,172 @@
+#include "UploadService.h"
+#include "Renderer.h"
+#ifndef GL_NO_GLFW
+    #include <GLFW/glfw3.h>
+#endif
+
+#ifndef GL_NO_GLFW
+UploadService::UploadService(GLFWwindow* shareWith)
+    : m_Quit(false), m_InFlight(0)
+{
+    // Same context settings as the one we share with, a hidden 1x1 window is the portable way to get one
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_Window = glfwCreateWindow(1, 1, "Upload", NULL, shareWith);
+    glfwDefaultWindowHints();
+    ASSERT(m_Window);
+
+    m_Thread = std::thread(&UploadService::WorkerLoop, this);
+}
+#endif
+
+UploadService::UploadService(const HeadlessContext& shareWith)
+    : m_Window(nullptr), m_Quit(false), m_InFlight(0)
+{
+    bool created = m_Headless.CreateShared(shareWith);
+    ASSERT(created);
+
+    m_Thread = std::thread(&UploadService::WorkerLoop, this);
+}
+
+UploadService::~UploadService()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_WakeWorker.notify_one();
+    m_Thread.join();
+
+    // Whatever was uploaded but never handed over still belongs to us, names are shared so they can go from here
+    for (Job& job : m_Uploaded) {
+        GLCall(glDeleteSync(job.fence));
+        GLCall(glDeleteBuffers(1, &job.buffer));
+    }
+#ifndef GL_NO_GLFW
+    if (m_Window)
+        glfwDestroyWindow(m_Window);
+#endif
+}
+
+void UploadService::WorkerLoop()
+{
+#ifndef GL_NO_GLFW
+    if (m_Window)
+        glfwMakeContextCurrent(m_Window);
+    else
+#endif
+        m_Headless.MakeCurrent();
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WakeWorker.wait(lock, [&]() { return m_Quit || !m_Pending.empty(); });
+            if (m_Quit)
+                break;
+            job = std::move(m_Pending.front());
+            m_Pending.pop_front();
+        }
+
+        /**
+        * The binds bypass this thread's state cache: buffers are deleted from the render context, and a
+        * name reused after that would look already bound here while GL still points at the deleted object.
+        * Unbinding after every upload also keeps this context from holding on to the buffer.
+        **/
+        GLCall(glGenBuffers(1, &job.buffer));
+        GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, job.buffer));
+        GLCall(glBufferData(GL_COPY_WRITE_BUFFER, job.data.size(), job.data.data(), GetGLBufferUsage(job.usage)));
+        GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+        GLCall(job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        // Fences only become visible to other contexts once they have been flushed
+        GLCall(glFlush());
+
+        job.size = (unsigned int)job.data.size();
+        job.data = std::vector<uint8_t>();
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Uploaded.push_back(std::move(job));
+    }
+#ifndef GL_NO_GLFW
+    if (m_Window)
+        glfwMakeContextCurrent(NULL);
+    else
+#endif
+        m_Headless.ReleaseCurrent();
+}
+
+void UploadService::Submit(Job&& job)
+{
+    job.size = 0;
+    job.buffer = 0;
+    job.fence = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Pending.push_back(std::move(job));
+    }
+    m_WakeWorker.notify_one();
+    m_InFlight++;
+}
+
+void UploadService::UploadVertices(const void* data, unsigned int size, BufferUsage usage, VertexCallback onReady)
+{
+    Job job;
+    job.data.assign((const uint8_t*)data, (const uint8_t*)data + size);
+    job.indices = false;
+    job.count = 0;
+    job.usage = usage;
+    job.onVertices = std::move(onReady);
+    Submit(std::move(job));
+}
+
+void UploadService::UploadIndices(const unsigned int* data, unsigned int count, IndexCallback onReady, PrimitiveTopology topology)
+{
+    PackedIndices packed = PackIndices(data, count, UsesPrimitiveRestart(topology));
+    Job job;
+    job.data = std::move(packed.data);
+    job.indices = true;
+    job.usage = BufferUsage::Static;
+    job.indexType = packed.type;
+    job.topology = topology;
+    job.count = count;
+    job.onIndices = std::move(onReady);
+    Submit(std::move(job));
+}
+
+unsigned int UploadService::Poll()
+{
+    // Only the swap runs under the lock, the fence checks and callbacks don't hold up the worker
+    std::deque<Job> uploaded;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        uploaded.swap(m_Uploaded);
+    }
+
+    // Fences signal in submission order, stop at the first one still pending
+    std::deque<Job> ready;
+    while (!uploaded.empty()) {
+        GLenum status;
+        GLCall(status = glClientWaitSync(uploaded.front().fence, 0, 0));
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        ready.push_back(std::move(uploaded.front()));
+        uploaded.pop_front();
+    }
+
+    // The worker only appends, what is still pending goes back in front of anything it added meanwhile
+    if (!uploaded.empty()) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = uploaded.rbegin(); it != uploaded.rend(); ++it)
+            m_Uploaded.push_front(std::move(*it));
+    }
+
+    for (Job& job : ready) {
+        GLCall(glDeleteSync(job.fence));
+        if (job.indices)
+            job.onIndices(IndexBuffer::Adopt(job.buffer, job.count, job.indexType, job.topology));
+        else
+            job.onVertices(VertexBuffer::Adopt(job.buffer, job.size, job.usage));
+    }
+    m_InFlight -= (unsigned int)ready.size();
+    return (unsigned int)ready.size();
+}
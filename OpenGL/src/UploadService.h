@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "HeadlessContext.h"
+
+struct GLFWwindow;
+struct __GLsync;
+
+/**
+* Creates vertex and index buffers on a worker thread that owns a context sharing objects with the
+* render context, so glBufferData never blocks a frame.
+* Each finished upload is fenced; Poll, called by the render thread once per frame, hands the buffers
+* whose fence has signalled to their callback and never waits for the ones still in flight.
+* Shares with a GLFW window or a HeadlessContext of any backend. Construct and destroy it on the thread that
+* created the one it shares with (GLFW creates windows on the main thread only).
+**/
+class UploadService
+{
+	public:
+		using VertexCallback = std::function<void(VertexBuffer&&)>;
+		using IndexCallback = std::function<void(IndexBuffer&&)>;
+
+	private:
+		struct Job
+		{
+			std::vector<uint8_t> data;
+			bool indices;
+			BufferUsage usage;
+			IndexType indexType;
+			PrimitiveTopology topology;
+			unsigned int count;		// indices
+			VertexCallback onVertices;
+			IndexCallback onIndices;
+
+			// Filled in by the worker
+			unsigned int size;
+			unsigned int buffer;
+			__GLsync* fence;
+		};
+
+		GLFWwindow* m_Window;	// hidden, only there for its context, null when sharing with a HeadlessContext
+		HeadlessContext m_Headless;
+		std::thread m_Thread;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_WakeWorker;
+		std::deque<Job> m_Pending;		// waiting for the worker
+		std::deque<Job> m_Uploaded;		// fenced by the worker, waiting for the GPU
+		bool m_Quit;
+
+		unsigned int m_InFlight;		// submitted and not handed over yet, render thread only
+
+		void WorkerLoop();
+		void Submit(Job&& job);
+
+	public:
+#ifndef GL_NO_GLFW
+		explicit UploadService(GLFWwindow* shareWith);
+#endif
+		explicit UploadService(const HeadlessContext& shareWith);
+		~UploadService();
+
+		UploadService(const UploadService&) = delete;
+		UploadService& operator=(const UploadService&) = delete;
+
+		// data is copied, the callback runs on the render thread from Poll
+		void UploadVertices(const void* data, unsigned int size, BufferUsage usage, VertexCallback onReady);
+		// Indices are packed to their smallest type here, before being queued
+		void UploadIndices(const unsigned int* data, unsigned int count, IndexCallback onReady,
+			PrimitiveTopology topology = PrimitiveTopology::Triangles);
+
+		// Hands over every upload the GPU has finished, returns how many
+		unsigned int Poll();
+
+		inline unsigned int GetInFlightCount() const { return m_InFlight; }
+};
@@ -1,43 +1,258 @@
 #include "VertexArray.h"
 #include "Renderer.h"
+#include "GLStateCache.h"
+#include "GLDeletionQueue.h"
+#include "GLCaps.h"
+#include "IndexBuffer.h"
+#include <algorithm>
+#include <cstdint>
 
 VertexArray::VertexArray()
+    : m_BaseVertex(0), m_Owned(true), m_VertexAttributeCount(0), m_InstanceAttributeCount(0), m_Stride(0), m_InstanceStride(0),
+      m_InstanceBuffer(0), m_InstanceOffset(0)
 {
-    GLCall(glGenVertexArrays(1, &m_RendererID));
+    // Created names are fully initialized objects, generated ones only become vertex arrays once bound
+    if (GLCaps::Get().directStateAccess) {
+        GLCall(glCreateVertexArrays(1, &m_RendererID));
+    }
+    else {
+        GLCall(glGenVertexArrays(1, &m_RendererID));
+    }
+}
+
+VertexArray::VertexArray(const VertexArray& owner, int baseVertex)
+    : m_RendererID(owner.m_RendererID), m_BaseVertex(baseVertex), m_Owned(false),
+      m_VertexAttributeCount(owner.m_VertexAttributeCount), m_InstanceAttributeCount(owner.m_InstanceAttributeCount),
+      m_Stride(owner.m_Stride), m_InstanceStride(owner.m_InstanceStride),
+      m_InstanceBuffer(owner.m_InstanceBuffer), m_InstanceOffset(owner.m_InstanceOffset)
+{
+    std::copy(owner.m_Format, owner.m_Format + m_VertexAttributeCount + m_InstanceAttributeCount, m_Format);
+}
+
+VertexArray::VertexArray(VertexArray&& other)
+    : m_RendererID(other.m_RendererID), m_BaseVertex(other.m_BaseVertex), m_Owned(other.m_Owned),
+      m_VertexAttributeCount(other.m_VertexAttributeCount), m_InstanceAttributeCount(other.m_InstanceAttributeCount),
+      m_Stride(other.m_Stride), m_InstanceStride(other.m_InstanceStride),
+      m_InstanceBuffer(other.m_InstanceBuffer), m_InstanceOffset(other.m_InstanceOffset)
+{
+    std::copy(other.m_Format, other.m_Format + m_VertexAttributeCount + m_InstanceAttributeCount, m_Format);
+    other.m_RendererID = 0;
+}
+
+VertexArray& VertexArray::operator=(VertexArray&& other)
+{
+    if (this != &other) {
+        if (m_RendererID && m_Owned)
+            GLDeletionQueue::Get().DeleteVertexArray(m_RendererID);
+        m_RendererID = other.m_RendererID;
+        m_BaseVertex = other.m_BaseVertex;
+        m_Owned = other.m_Owned;
+        m_VertexAttributeCount = other.m_VertexAttributeCount;
+        m_InstanceAttributeCount = other.m_InstanceAttributeCount;
+        m_Stride = other.m_Stride;
+        m_InstanceStride = other.m_InstanceStride;
+        m_InstanceBuffer = other.m_InstanceBuffer;
+        m_InstanceOffset = other.m_InstanceOffset;
+        std::copy(other.m_Format, other.m_Format + m_VertexAttributeCount + m_InstanceAttributeCount, m_Format);
+        other.m_RendererID = 0;
+    }
+    return *this;
 }
 
 VertexArray::~VertexArray()
 {
-    GLCall(glDeleteVertexArrays(1, &m_RendererID));
+    // Deleted once the draws using it have retired
+    if (m_RendererID && m_Owned)
+        GLDeletionQueue::Get().DeleteVertexArray(m_RendererID);
+}
+
+void VertexArray::SplitOffset(uintptr_t offset, unsigned int stride, uintptr_t& attributeOffset, int& baseVertex)
+{
+    if (stride && offset % stride == 0) {
+        baseVertex = (int)(offset / stride);
+        attributeOffset = 0;
+    }
+    else {
+        baseVertex = 0;
+        attributeOffset = offset;
+    }
+}
+
+void VertexArray::ApplyFormat(unsigned int first, unsigned int count, unsigned int binding)
+{
+    // Attributes only store their relative offset, the binding holds the buffer, start offset, stride and divisor
+    const unsigned int divisor = binding == InstanceBinding && count ? m_Format[first].divisor : 0;
+    if (GLCaps::Get().directStateAccess) {
+        for (unsigned int i = first; i < first + count; i++) {
+            const VertexBufferElement& element = m_Format[i];
+            GLCall(glEnableVertexArrayAttrib(m_RendererID, i));
+            GLCall(glVertexArrayAttribFormat(m_RendererID, i, element.count, element.type, element.normalized, element.offset));
+            GLCall(glVertexArrayAttribBinding(m_RendererID, i, binding));
+        }
+        if (binding == InstanceBinding) {
+            GLCall(glVertexArrayBindingDivisor(m_RendererID, binding, divisor));
+        }
+    }
+    else if (GLCaps::Get().vertexAttribBinding) {
+        Bind();
+        for (unsigned int i = first; i < first + count; i++) {
+            const VertexBufferElement& element = m_Format[i];
+            GLCall(glEnableVertexAttribArray(i));
+            GLCall(glVertexAttribFormat(i, element.count, element.type, element.normalized, element.offset));
+            GLCall(glVertexAttribBinding(i, binding));
+        }
+        if (binding == InstanceBinding) {
+            GLCall(glVertexBindingDivisor(binding, divisor));
+        }
+    }
+}
+
+void VertexArray::DisableAttributes(unsigned int first, unsigned int end)
+{
+    if (first >= end)
+        return;
+    if (GLCaps::Get().directStateAccess) {
+        for (unsigned int i = first; i < end; i++) {
+            GLCall(glDisableVertexArrayAttrib(m_RendererID, i));
+        }
+        return;
+    }
+    Bind();
+    const bool attributeDivisors = !GLCaps::Get().vertexAttribBinding;
+    for (unsigned int i = first; i < end; i++) {
+        GLCall(glDisableVertexAttribArray(i));
+        // Without bindings the divisor stays with the index, clear it for whatever format uses the index next
+        if (attributeDivisors) {
+            GLCall(glVertexAttribDivisor(i, 0));
+        }
+    }
+}
+
+void VertexArray::SetFormat(const VertexBufferElement* elements, unsigned int elementCount, unsigned int stride)
+{
+    const unsigned int previousInstanceFirst = m_VertexAttributeCount;
+    const unsigned int previousEnd = m_VertexAttributeCount + m_InstanceAttributeCount;
+    if (elementCount && elements[0].divisor) {
+        ASSERT(m_VertexAttributeCount + elementCount <= MaxAttributes);
+        std::copy(elements, elements + elementCount, m_Format + m_VertexAttributeCount);
+        m_InstanceAttributeCount = elementCount;
+        m_InstanceStride = stride;
+        ApplyFormat(m_VertexAttributeCount, elementCount, InstanceBinding);
+        DisableAttributes(m_VertexAttributeCount + elementCount, previousEnd);
+        return;
+    }
+
+    ASSERT(elementCount + m_InstanceAttributeCount <= MaxAttributes);
+    // The instance attributes keep following the per-vertex ones, a new count moves them
+    const bool moved = elementCount != m_VertexAttributeCount && m_InstanceAttributeCount;
+    VertexBufferElement instance[MaxAttributes];
+    std::copy_n(m_Format + m_VertexAttributeCount, m_InstanceAttributeCount, instance);
+    std::copy(elements, elements + elementCount, m_Format);
+    std::copy_n(instance, m_InstanceAttributeCount, m_Format + elementCount);
+    m_VertexAttributeCount = elementCount;
+    m_Stride = stride;
+    ApplyFormat(0, elementCount, VertexBinding);
+    if (moved)
+        ApplyFormat(m_VertexAttributeCount, m_InstanceAttributeCount, InstanceBinding);
+
+    /**
+    * Without bindings the divisor is per attribute: indices the instance attributes moved off keep theirs.
+    * Nothing holds the instance buffer for the new indices either, so point them at the last one again.
+    **/
+    if (moved && !GLCaps::Get().directStateAccess && !GLCaps::Get().vertexAttribBinding) {
+        Bind();
+        for (unsigned int i = previousInstanceFirst; i < std::min(elementCount, previousEnd); i++) {
+            GLCall(glVertexAttribDivisor(i, 0));
+        }
+        if (m_InstanceBuffer)
+            PointInstanceAttributes(m_InstanceBuffer, m_InstanceOffset);
+    }
+    // A smaller format leaves attributes enabled past its end
+    DisableAttributes(m_VertexAttributeCount + m_InstanceAttributeCount, previousEnd);
 }
 
-// Binds the vertex array and buffer and sets up layout
-void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+int VertexArray::BindVertexBuffer(const VertexBuffer& vb) const
 {
+    uintptr_t offset;
+    int baseVertex;
+    SplitOffset(vb.GetOffset(), m_Stride, offset, baseVertex);
+    if (GLCaps::Get().directStateAccess) {
+        GLStateCache::Get().VertexArrayVertexBuffer(m_RendererID, VertexBinding, vb.GetRendererID(), offset, m_Stride);
+        return baseVertex;
+    }
+    Bind();
+    if (GLCaps::Get().vertexAttribBinding) {
+        GLStateCache::Get().BindVertexBuffer(VertexBinding, vb.GetRendererID(), offset, m_Stride);
+        return baseVertex;
+    }
+
+    // glVertexAttribPointer captures the buffer bound to GL_ARRAY_BUFFER along with the format
+    vb.Bind();
+    for (unsigned int i = 0; i < m_VertexAttributeCount; i++) {
+        const VertexBufferElement& element = m_Format[i];
+        GLCall(glEnableVertexAttribArray(i));
+        GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, m_Stride, (const void*)(offset + element.offset)));
+    }
+    return baseVertex;
+}
+
+void VertexArray::BindInstanceBuffer(const VertexBuffer& vb) const
+{
+    // No base instance before GL 4.2, the whole offset goes to the binding
+    const uintptr_t offset = vb.GetOffset();
+    if (GLCaps::Get().directStateAccess) {
+        GLStateCache::Get().VertexArrayVertexBuffer(m_RendererID, InstanceBinding, vb.GetRendererID(), offset, m_InstanceStride);
+        return;
+    }
+    Bind();
+    if (GLCaps::Get().vertexAttribBinding) {
+        GLStateCache::Get().BindVertexBuffer(InstanceBinding, vb.GetRendererID(), offset, m_InstanceStride);
+        return;
+    }
+
+    m_InstanceBuffer = vb.GetRendererID();
+    m_InstanceOffset = offset;
+    PointInstanceAttributes(m_InstanceBuffer, m_InstanceOffset);
+}
+
+void VertexArray::PointInstanceAttributes(unsigned int buffer, uintptr_t offset) const
+{
+    // The vertex array is bound, glVertexAttribPointer captures GL_ARRAY_BUFFER along with the format
+    GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (unsigned int i = m_VertexAttributeCount; i < m_VertexAttributeCount + m_InstanceAttributeCount; i++) {
+        const VertexBufferElement& element = m_Format[i];
+        GLCall(glEnableVertexAttribArray(i));
+        GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, m_InstanceStride, (const void*)(offset + element.offset)));
+        GLCall(glVertexAttribDivisor(i, element.divisor));
+    }
+}
+
+void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferElement* elements, unsigned int elementCount, unsigned int stride)
+{
+    SetFormat(elements, elementCount, stride);
+    if (elementCount && elements[0].divisor)
+        BindInstanceBuffer(vb);
+    else
+        m_BaseVertex = BindVertexBuffer(vb);
+}
+
+void VertexArray::SetIndexBuffer(const IndexBuffer& ib)
+{
+    if (GLCaps::Get().directStateAccess) {
+        GLCall(glVertexArrayElementBuffer(m_RendererID, ib.GetRendererID()));
+        GLStateCache::Get().OnVertexArrayElementBuffer(m_RendererID, ib.GetRendererID());
+        return;
+    }
     Bind();
-	vb.Bind();
-    const auto& elements = layout.GetElements();
-    unsigned int offset = 0;
-    for (unsigned int i = 0; i < elements.size(); i++) {
-        const auto& element = elements[i];
-        /**
-        * SPECIFY LAYOUT OF DATA
-        */
-        //Can define and enable as long a buffer has been bound (as above)
-        //index of 0 because first attribute, 2 float represent a single attribute/vertex, type of data = floats, non-normalized as floats are already normalized, stride - # bytes between each vertex/offset to next vertex, offset to the next attribute i.e. texture coord
-        GLCall(glEnableVertexAttribArray(i)); //can come before or after glVertexAttribPointer, as long as buffer has been bound
-        GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*)offset)); // LINKS BUFFER WITH VAO
-        offset += element.count * VertexBufferElement::GetSizeOfType(element.type);;
-    }
-    
+    ib.Bind();
 }
 
 void VertexArray::Bind() const
 {
-    GLCall(glBindVertexArray(m_RendererID));
+    GLStateCache::Get().BindVertexArray(m_RendererID);
 }
 
 void VertexArray::Unbind() const
 {
-    GLCall(glBindVertexArray(0));
+    GLStateCache::Get().BindVertexArray(0);
 }
@@ -2,17 +2,116 @@
 
 #include "VertexBuffer.h"
 #include "VertexBufferLayout.h"
+#include <cstdint>
+
+class IndexBuffer;
 
 class VertexArray {
+	public:
+		static const unsigned int MaxAttributes = 16;	// GL_MAX_VERTEX_ATTRIBS guaranteed by every GL 3.3 context
+		static const unsigned int VertexBinding = 0;
+		static const unsigned int InstanceBinding = 1;
+
 	private :
 		unsigned int m_RendererID;
+		int m_BaseVertex;
+		bool m_Owned;	// false for views of a VertexArrayCache entry
+		// Kept for BindVertexBuffer: the stride splits buffer offsets, contexts without attribute bindings respecify from it.
+		// Per-vertex attributes come first, the per-instance ones follow.
+		VertexBufferElement m_Format[MaxAttributes];
+		unsigned int m_VertexAttributeCount;
+		unsigned int m_InstanceAttributeCount;
+		unsigned int m_Stride;
+		unsigned int m_InstanceStride;
+		// Contexts without attribute bindings: what BindInstanceBuffer last pointed the instance attributes at,
+		// for SetFormat to point them at again once a new per-vertex count has renumbered them
+		mutable unsigned int m_InstanceBuffer;
+		mutable uintptr_t m_InstanceOffset;
+
+		// View sharing owner's GL vertex array and format
+		VertexArray(const VertexArray& owner, int baseVertex);
+
+		// Whole vertex offsets become a base vertex, anything else stays an attribute offset
+		static void SplitOffset(uintptr_t offset, unsigned int stride, uintptr_t& attributeOffset, int& baseVertex);
+
+		// Specifies count attributes of m_Format starting at first as reading binding, when the context has bindings
+		void ApplyFormat(unsigned int first, unsigned int count, unsigned int binding);
+
+		// Disables the attributes in [first, end) a previous format left enabled
+		void DisableAttributes(unsigned int first, unsigned int end);
+
+		// Specifies the instance attributes as reading buffer, contexts without attribute bindings only
+		void PointInstanceAttributes(unsigned int buffer, uintptr_t offset) const;
+
+		friend class VertexArrayCache;
 
 	public:
 		VertexArray();
 		~ VertexArray();
 
-		void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+		// Move only, a copy would delete the GL vertex array twice
+		VertexArray(const VertexArray&) = delete;
+		VertexArray& operator=(const VertexArray&) = delete;
+		VertexArray(VertexArray&& other);
+		VertexArray& operator=(VertexArray&& other);
+
+		/**
+		* Describes the attributes once, all reading from buffer binding 0. With attribute bindings (GL 4.3) the
+		* format lives in the vertex array and buffers are attached later by BindVertexBuffer, so one vertex array
+		* serves every mesh of the format. Older contexts only store it for BindVertexBuffer to respecify.
+		* Instanced layouts (PushInstanced) describe binding 1 instead, their attributes are numbered after the
+		* per-vertex ones and are attached with BindInstanceBuffer.
+		**/
+		void SetFormat(const VertexBufferElement* elements, unsigned int elementCount, unsigned int stride);
+
+		inline void SetFormat(const VertexBufferLayout& layout) {
+			SetFormat(layout.GetElements().data(), (unsigned int)layout.GetElements().size(), layout.GetStride());
+		}
+
+		template<size_t N>
+		inline void SetFormat(const StaticVertexLayout<N>& layout) {
+			SetFormat(layout.elements, layout.GetCount(), layout.stride);
+		}
+
+		/**
+		* Attaches vb to binding 0 and returns the base vertex to draw it with. Data starting on a whole vertex is
+		* addressed with a base vertex instead of a buffer offset, so meshes sharing a GL buffer don't even rebind.
+		* With attribute bindings this is a single cached glBindVertexBuffer, otherwise every attribute is respecified.
+		* Leaves the vertex array bound unless direct state access is available.
+		**/
+		int BindVertexBuffer(const VertexBuffer& vb) const;
+
+		// Attaches vb to the instance binding, read with the instanced format's stride and divisor
+		void BindInstanceBuffer(const VertexBuffer& vb) const;
+
+		/**
+		* SetFormat then BindVertexBuffer, keeping the base vertex for GetBaseVertex, or BindInstanceBuffer for
+		* instanced layouts. Add the per-vertex buffer first so the instance attributes land right after it:
+		*   layout(location = 0) in vec2 position;	// AddBuffer(quad, { Push<float>(2) })
+		*   layout(location = 1) in vec2 offset;		// AddBuffer(instances, { PushInstanced<float>(2) })
+		* A per-vertex layout with another attribute count renumbers the instance attributes, which keep reading
+		* the instance buffer added last: it has to still be alive then, or be added again.
+		* Capture happens now: call again after vb moves (ring buffer update, heap defragmentation)
+		**/
+		void AddBuffer(const VertexBuffer& vb, const VertexBufferElement* elements, unsigned int elementCount, unsigned int stride);
+
+		inline void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) {
+			AddBuffer(vb, layout.GetElements().data(), (unsigned int)layout.GetElements().size(), layout.GetStride());
+		}
+
+		template<size_t N>
+		inline void AddBuffer(const VertexBuffer& vb, const StaticVertexLayout<N>& layout) {
+			AddBuffer(vb, layout.elements, layout.GetCount(), layout.stride);
+		}
+
+		// Attaches ib as the element buffer, part of the vertex array state like the attributes
+		void SetIndexBuffer(const IndexBuffer& ib);
 
 		void Bind() const;
 		void Unbind() const;
+
+		inline unsigned int GetRendererID() const { return m_RendererID; }
+		inline unsigned int GetStride() const { return m_Stride; }
+		// Added to every index drawn from this vertex array
+		inline int GetBaseVertex() const { return m_BaseVertex; }
 };
\ No newline at end of file
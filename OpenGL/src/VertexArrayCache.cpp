@@ -0,0 +1,111 @@
+#include "VertexArrayCache.h"
+#include "IndexBuffer.h"
+#include "GLStateCache.h"
+
+size_t VertexArrayCache::KeyHash::operator()(const Key& key) const
+{
+    uint64_t hash = key.layoutHash;
+    for (uint64_t value : { (uint64_t)key.vertexBuffer, (uint64_t)key.indexBuffer, (uint64_t)key.attributeOffset })
+        hash = (hash ^ value) * 1099511628211ull;
+    return (size_t)hash;
+}
+
+VertexArrayCache::VertexArrayCache()
+    : m_Stats({ 0, 0, 0 })
+{
+    GLStateCache::Get().AddDeleteBufferListener(&VertexArrayCache::OnDeleteBuffer, this);
+}
+
+VertexArrayCache::~VertexArrayCache()
+{
+    GLStateCache::Get().RemoveDeleteBufferListener(&VertexArrayCache::OnDeleteBuffer, this);
+}
+
+void VertexArrayCache::OnDeleteBuffer(void* cache, unsigned int buffer)
+{
+    ((VertexArrayCache*)cache)->Evict(buffer);
+}
+
+void VertexArrayCache::Evict(unsigned int buffer)
+{
+    // A reused name would otherwise hit an array still pointing at the deleted buffer. Most deleted buffers
+    // were never cached, the index keeps those to a lookup.
+    auto range = m_KeysByBuffer.equal_range(buffer);
+    if (range.first == range.second)
+        return;
+    for (auto it = range.first; it != range.second; ++it) {
+        const Key& key = it->second;
+        m_VertexArrays.erase(key);
+        // The entry is also indexed under its other buffer
+        const unsigned int other = key.vertexBuffer == buffer ? key.indexBuffer : key.vertexBuffer;
+        if (other && other != buffer)
+            Unindex(other, key);
+    }
+    m_KeysByBuffer.erase(range.first, range.second);
+    m_Stats.vertexArrays = (unsigned int)(m_VertexArrays.size() + m_Formats.size());
+}
+
+void VertexArrayCache::Unindex(unsigned int buffer, const Key& key)
+{
+    auto range = m_KeysByBuffer.equal_range(buffer);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == key) {
+            m_KeysByBuffer.erase(it);
+            return;
+        }
+    }
+}
+
+VertexArray VertexArrayCache::Get(const VertexBuffer& vb, const VertexBufferElement* elements, unsigned int elementCount,
+    unsigned int stride, const IndexBuffer* ib)
+{
+    Key key;
+    int baseVertex;
+    VertexArray::SplitOffset(vb.GetOffset(), stride, key.attributeOffset, baseVertex);
+    key.layoutHash = HashVertexLayout(elements, elementCount, stride);
+    key.vertexBuffer = vb.GetRendererID();
+    key.indexBuffer = ib ? ib->GetRendererID() : 0;
+
+    auto it = m_VertexArrays.find(key);
+    if (it != m_VertexArrays.end()) {
+        m_Stats.hits++;
+        return VertexArray(it->second, baseVertex);
+    }
+
+    m_Stats.misses++;
+    VertexArray va;
+    va.AddBuffer(vb, elements, elementCount, stride);
+    if (ib)
+        va.SetIndexBuffer(*ib);
+    it = m_VertexArrays.emplace(key, std::move(va)).first;
+    m_KeysByBuffer.emplace(key.vertexBuffer, key);
+    if (key.indexBuffer && key.indexBuffer != key.vertexBuffer)
+        m_KeysByBuffer.emplace(key.indexBuffer, key);
+    m_Stats.vertexArrays = (unsigned int)(m_VertexArrays.size() + m_Formats.size());
+    return VertexArray(it->second, baseVertex);
+}
+
+VertexArray VertexArrayCache::GetFormat(const VertexBufferElement* elements, unsigned int elementCount, unsigned int stride)
+{
+    uint64_t layoutHash = HashVertexLayout(elements, elementCount, stride);
+    auto it = m_Formats.find(layoutHash);
+    if (it != m_Formats.end()) {
+        m_Stats.hits++;
+        return VertexArray(it->second, 0);
+    }
+
+    m_Stats.misses++;
+    VertexArray va;
+    va.SetFormat(elements, elementCount, stride);
+    it = m_Formats.emplace(layoutHash, std::move(va)).first;
+    m_Stats.vertexArrays = (unsigned int)(m_VertexArrays.size() + m_Formats.size());
+    return VertexArray(it->second, 0);
+}
+
+void VertexArrayCache::Clear()
+{
+    m_VertexArrays.clear();
+    m_KeysByBuffer.clear();
+    m_Formats.clear();
+    m_Stats.vertexArrays = 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include "VertexArray.h"
+
+class IndexBuffer;
+
+/**
+* Shares configured vertex arrays between meshes, keyed by (layout hash, vertex buffer, attribute offset, index buffer).
+* Meshes sub-allocated from the same GL buffer with the same layout differ only by base vertex, so they all get
+* the same GL vertex array and the number of arrays follows the number of formats rather than the number of meshes.
+* GetFormat goes further where attribute bindings are available: one array per layout, with buffers attached
+* per draw through VertexArray::BindVertexBuffer.
+* The views handed out don't own anything and must not outlive the cache or a Clear.
+* GL reuses buffer names, so entries reading a buffer are evicted when GLStateCache learns of its deletion.
+* Each cache registers itself as a listener of the thread's GLStateCache, so it can't be copied or moved.
+**/
+class VertexArrayCache
+{
+	public:
+		struct Stats
+		{
+			unsigned int hits;
+			unsigned int misses;
+			unsigned int vertexArrays;
+		};
+
+	private:
+		struct Key
+		{
+			uint64_t layoutHash;
+			unsigned int vertexBuffer;
+			unsigned int indexBuffer;
+			uintptr_t attributeOffset;
+
+			inline bool operator==(const Key& other) const {
+				return layoutHash == other.layoutHash && vertexBuffer == other.vertexBuffer &&
+					indexBuffer == other.indexBuffer && attributeOffset == other.attributeOffset;
+			}
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const;
+		};
+
+		std::unordered_map<Key, VertexArray, KeyHash> m_VertexArrays;
+		std::unordered_multimap<unsigned int, Key> m_KeysByBuffer;	// vertex and index buffer -> entries reading it
+		std::unordered_map<uint64_t, VertexArray> m_Formats;	// layout hash -> array without a buffer attached
+		Stats m_Stats;
+
+		// Drops the entries reading buffer, a GLStateCache delete buffer listener
+		static void OnDeleteBuffer(void* cache, unsigned int buffer);
+		void Evict(unsigned int buffer);
+		void Unindex(unsigned int buffer, const Key& key);
+
+	public:
+		VertexArrayCache();
+		~VertexArrayCache();
+
+		VertexArrayCache(const VertexArrayCache&) = delete;
+		VertexArrayCache& operator=(const VertexArrayCache&) = delete;
+
+		/**
+		* Returns a view of a vertex array reading vb with the given layout, with ib bound when not null.
+		* On a miss the array is created and configured once, hits cost a hash lookup and no GL calls.
+		**/
+		VertexArray Get(const VertexBuffer& vb, const VertexBufferElement* elements, unsigned int elementCount,
+			unsigned int stride, const IndexBuffer* ib = nullptr);
+
+		inline VertexArray Get(const VertexBuffer& vb, const VertexBufferLayout& layout, const IndexBuffer* ib = nullptr) {
+			return Get(vb, layout.GetElements().data(), (unsigned int)layout.GetElements().size(), layout.GetStride(), ib);
+		}
+
+		template<size_t N>
+		inline VertexArray Get(const VertexBuffer& vb, const StaticVertexLayout<N>& layout, const IndexBuffer* ib = nullptr) {
+			return Get(vb, layout.elements, layout.GetCount(), layout.stride, ib);
+		}
+
+		/**
+		* Returns a view of the vertex array shared by every mesh with this layout, no buffer attached.
+		* Draw with BindVertexBuffer(vb) and the base vertex it returns, each switch between meshes is then one
+		* buffer rebind. Without attribute bindings the rebind respecifies every attribute, prefer Get there.
+		**/
+		VertexArray GetFormat(const VertexBufferElement* elements, unsigned int elementCount, unsigned int stride);
+
+		inline VertexArray GetFormat(const VertexBufferLayout& layout) {
+			return GetFormat(layout.GetElements().data(), (unsigned int)layout.GetElements().size(), layout.GetStride());
+		}
+
+		template<size_t N>
+		inline VertexArray GetFormat(const StaticVertexLayout<N>& layout) {
+			return GetFormat(layout.elements, layout.GetCount(), layout.stride);
+		}
+
+		// Releases every vertex array, e.g. after defragmenting the heap moved the buffers they point at
+		void Clear();
+
+		inline const Stats& GetStats() const { return m_Stats; }
+		inline void ResetStats() { m_Stats.hits = m_Stats.misses = 0; }
+};
@@ -1,26 +1,194 @@
 #include "VertexBuffer.h"
 #include "Renderer.h"
+#include "GLStateCache.h"
+#include "RingBuffer.h"
+#include "GpuHeap.h"
+#include "GLDeletionQueue.h"
+#include "GLCaps.h"
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+unsigned int GetGLBufferUsage(BufferUsage usage)
 {
+    switch (usage) {
+        case BufferUsage::Dynamic: return GL_DYNAMIC_DRAW;
+        case BufferUsage::Stream:  return GL_STREAM_DRAW;
+        default:                   return GL_STATIC_DRAW;
+    }
+}
+
+VertexBuffer::VertexBuffer()
+    : m_RendererID(0), m_Size(0), m_Usage(BufferUsage::Static), m_Ring(nullptr), m_Heap(nullptr), m_Allocation(0), m_Offset(0), m_Immutable(false), m_Overflow(0)
+{
+}
+
+VertexBuffer::VertexBuffer(const void* data, unsigned int size, BufferUsage usage)
+    : m_Size(size), m_Usage(usage), m_Ring(nullptr), m_Heap(nullptr), m_Allocation(0), m_Offset(0), m_Immutable(false), m_Overflow(0)
+{
+    if (GLCaps::Get().directStateAccess) {
+        // Created and filled by name, nothing gets bound
+        GLCall(glCreateBuffers(1, &m_RendererID));
+        // Static data known up front is never written again: immutable storage without even the dynamic bit.
+        // Zero sized storage is an error, and one allocated without data still needs its contents.
+        if (usage == BufferUsage::Static && data && size) {
+            GLCall(glNamedBufferStorage(m_RendererID, size, data, 0));
+            m_Immutable = true;
+        }
+        else {
+            GLCall(glNamedBufferData(m_RendererID, size, data, GetGLBufferUsage(usage)));
+        }
+        return;
+    }
+
     GLCall(glGenBuffers(1, &m_RendererID));
     //select/bind buffer
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
     //Put data into buffer - type of buffer, size of buffer/data, 
-    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GetGLBufferUsage(usage)));
+}
+
+VertexBuffer::VertexBuffer(RingBuffer& ring)
+    : m_RendererID(ring.GetRendererID()), m_Size(0), m_Usage(BufferUsage::Stream), m_Ring(&ring), m_Heap(nullptr), m_Allocation(0), m_Offset(0), m_Immutable(false), m_Overflow(0)
+{
+}
+
+VertexBuffer::VertexBuffer(GpuHeap& heap, const void* data, unsigned int size, unsigned int stride)
+    : m_Size(size), m_Usage(BufferUsage::Static), m_Ring(nullptr), m_Heap(&heap), m_Offset(0), m_Immutable(false), m_Overflow(0)
+{
+    GpuHeap::Allocation allocation = heap.Allocate(size, stride);
+    m_RendererID = allocation.buffer;
+    m_Allocation = allocation.handle;
+    if (data)
+        heap.Upload(m_Allocation, data, size);
+}
+
+VertexBuffer::VertexBuffer(VertexBuffer&& other)
+    : m_RendererID(other.m_RendererID), m_Size(other.m_Size), m_Usage(other.m_Usage), m_Ring(other.m_Ring),
+    m_Heap(other.m_Heap), m_Allocation(other.m_Allocation), m_Offset(other.m_Offset), m_Immutable(other.m_Immutable),
+    m_Overflow(other.m_Overflow)
+{
+    other.m_RendererID = 0;
+    other.m_Overflow = 0;
+    other.m_Ring = nullptr;
+    other.m_Heap = nullptr;
+}
+
+VertexBuffer& VertexBuffer::operator=(VertexBuffer&& other)
+{
+    if (this != &other) {
+        Release();
+        m_RendererID = other.m_RendererID;
+        m_Size = other.m_Size;
+        m_Usage = other.m_Usage;
+        m_Ring = other.m_Ring;
+        m_Heap = other.m_Heap;
+        m_Allocation = other.m_Allocation;
+        m_Offset = other.m_Offset;
+        m_Immutable = other.m_Immutable;
+        m_Overflow = other.m_Overflow;
+        other.m_RendererID = 0;
+        other.m_Overflow = 0;
+        other.m_Ring = nullptr;
+        other.m_Heap = nullptr;
+    }
+    return *this;
+}
+
+VertexBuffer VertexBuffer::Adopt(unsigned int rendererID, unsigned int size, BufferUsage usage)
+{
+    VertexBuffer vb;
+    vb.m_RendererID = rendererID;
+    vb.m_Size = size;
+    vb.m_Usage = usage;
+    return vb;
 }
 
 VertexBuffer::~VertexBuffer()
 {
-    GLCall(glDeleteBuffers(1, &m_RendererID));
+    Release();
+}
+
+void VertexBuffer::Release()
+{
+    // The ring owns the storage of streamed buffers, only the overflow buffer is ours
+    if (m_Ring) {
+        if (m_Overflow)
+            GLDeletionQueue::Get().DeleteBuffer(m_Overflow);
+        return;
+    }
+    if (m_Heap) {
+        m_Heap->Free(m_Allocation);
+        return;
+    }
+    // Draws still in flight may read the buffer, it is deleted once they retire
+    if (m_RendererID)
+        GLDeletionQueue::Get().DeleteBuffer(m_RendererID);
 }
 
 void VertexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, GetRendererID());
 }
 
 void VertexBuffer::Unbind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VertexBuffer::Update(const void* data, unsigned int size, unsigned int offset)
+{
+    if (m_Ring) {
+        ASSERT(offset == 0);
+        RingBuffer::Allocation allocation = m_Ring->Write(data, size);
+        m_Size = size;
+        if (allocation.data) {
+            m_RendererID = m_Ring->GetRendererID();
+            m_Offset = allocation.offset;
+            return;
+        }
+        // The frame's region is full: orphan a buffer of our own instead, draws in flight keep the old storage
+        if (!m_Overflow) {
+            GLCall(glGenBuffers(1, &m_Overflow));
+        }
+        GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, m_Overflow);
+        GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, data, GL_STREAM_DRAW));
+        m_RendererID = m_Overflow;
+        m_Offset = 0;
+        return;
+    }
+    if (m_Heap) {
+        m_Heap->Upload(m_Allocation, data, size, offset);
+        return;
+    }
+
+    // Immutable storage can neither be orphaned nor grown, create buffers that change as Dynamic or Stream
+    ASSERT(!m_Immutable);
+    if (GLCaps::Get().directStateAccess) {
+        if (offset == 0 && size >= m_Size) {
+            GLCall(glNamedBufferData(m_RendererID, size, data, GetGLBufferUsage(m_Usage)));
+            m_Size = size;
+            return;
+        }
+        ASSERT(offset + size <= m_Size);
+        GLCall(glNamedBufferSubData(m_RendererID, offset, size, data));
+        return;
+    }
+
+    GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+    if (offset == 0 && size >= m_Size) {
+        // Respecifying the storage orphans the old one: draws in flight keep reading it, we get new memory right away
+        GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GetGLBufferUsage(m_Usage)));
+        m_Size = size;
+        return;
+    }
+    ASSERT(offset + size <= m_Size);
+    GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+}
+
+unsigned int VertexBuffer::GetOffset() const
+{
+    return m_Heap ? m_Heap->GetOffset(m_Allocation) : m_Offset;
+}
+
+unsigned int VertexBuffer::GetRendererID() const
+{
+    return m_Heap ? m_Heap->GetBuffer(m_Allocation) : m_RendererID;
 }
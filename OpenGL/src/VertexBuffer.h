@@ -1,14 +1,76 @@
 #pragma once
 
+class RingBuffer;
+class GpuHeap;
+
+/**
+* How often the contents are expected to change, picks the GL usage hint
+*   Static  - uploaded once
+*   Dynamic - updated now and then, drawn many times in between
+*   Stream  - rewritten about every frame
+**/
+enum class BufferUsage
+{
+	Static,
+	Dynamic,
+	Stream
+};
+
+// GL_STATIC_DRAW, GL_DYNAMIC_DRAW or GL_STREAM_DRAW
+unsigned int GetGLBufferUsage(BufferUsage usage);
+
 class VertexBuffer
 {
 	private:
 		unsigned int m_RendererID;
+		unsigned int m_Size;
+		BufferUsage m_Usage;
+		RingBuffer* m_Ring;		// backing store of streamed buffers, null when the buffer owns its storage
+		GpuHeap* m_Heap;		// backing store of sub-allocated buffers
+		unsigned int m_Allocation;
+		unsigned int m_Offset;	// where the contents start inside the GL buffer
+		bool m_Immutable;		// static buffers created with data through DSA get fixed, read-only storage
+		unsigned int m_Overflow;	// own buffer a ring backed one streams through while the ring region is full
+
+		VertexBuffer();
+		void Release();
 
 	public:
-		VertexBuffer(const void* data, unsigned int size);
+		// data may be null to only allocate the storage
+		VertexBuffer(const void* data, unsigned int size, BufferUsage usage = BufferUsage::Static);
+		// Streamed buffer living in the ring, every Update writes a new copy into the current frame's region
+		explicit VertexBuffer(RingBuffer& ring);
+		// Sub-allocated from the heap, aligned to the vertex stride so it can be drawn with a base vertex
+		VertexBuffer(GpuHeap& heap, const void* data, unsigned int size, unsigned int stride);
 		~VertexBuffer();
 
+		// Move only, a copy would delete the GL buffer twice
+		VertexBuffer(const VertexBuffer&) = delete;
+		VertexBuffer& operator=(const VertexBuffer&) = delete;
+		VertexBuffer(VertexBuffer&& other);
+		VertexBuffer& operator=(VertexBuffer&& other);
+
+		// Takes ownership of a buffer created elsewhere, e.g. by the upload thread
+		static VertexBuffer Adopt(unsigned int rendererID, unsigned int size, BufferUsage usage);
+
 		void Bind() const;
 		void Unbind() const;
-};
\ No newline at end of file
+
+		/**
+		* Writes size bytes at offset
+		* A write covering the whole buffer orphans the old storage, so the driver hands out fresh memory
+		* instead of waiting for draws still reading the previous contents. Writing past the end grows the
+		* buffer, which is only allowed from offset 0 since the old contents are not kept.
+		* Ring backed buffers only take whole rewrites (offset 0) and move to a new offset each time, when the
+		* frame's region is full they fall back to orphaning a buffer of their own until the ring has room again,
+		* heap backed ones can't grow. Static buffers created with data through DSA have immutable storage and
+		* can't be updated at all: use Dynamic for anything written after creation.
+		**/
+		void Update(const void* data, unsigned int size, unsigned int offset = 0);
+
+		inline unsigned int GetSize() const { return m_Size; }
+		inline BufferUsage GetUsage() const { return m_Usage; }
+		// Heap backed buffers move when the heap is defragmented, these always return the current location
+		unsigned int GetOffset() const;
+		unsigned int GetRendererID() const;
+};
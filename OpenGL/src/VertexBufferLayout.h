@@ -1,57 +1,162 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 #include "Renderer.h"
+#include "VertexEncoding.h"
 
 struct VertexBufferElement
 {
 	unsigned int type;
-	unsigned int count;	
+	unsigned int count;
 	unsigned char normalized;
+	unsigned int offset;	// bytes from the start of the vertex
+	unsigned int divisor;	// 0 advances per vertex, n advances every n instances
 
 	static unsigned int GetSizeOfType(unsigned int type) {
 		switch (type) {
 			case GL_FLOAT: return 4;
 			case GL_UNSIGNED_INT: return 4;
 			case GL_UNSIGNED_BYTE: return 1;
+			case GL_HALF_FLOAT: return 2;
+			case GL_SHORT: return 2;
 		}
 		ASSERT(false);
 		return 0;
 	}
+
+	// Bytes taken by count components, packed formats hold all four components in one 32-bit word
+	static unsigned int GetSizeOfElement(unsigned int type, unsigned int count) {
+		if (type == GL_INT_2_10_10_10_REV)
+			return 4;
+		return count * GetSizeOfType(type);
+	}
+};
+
+// FNV-1a over the elements and stride, equal layouts hash equal however they were built
+inline uint64_t HashVertexLayout(const VertexBufferElement* elements, unsigned int elementCount, unsigned int stride)
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](unsigned int value) {
+		hash ^= value;
+		hash *= 1099511628211ull;
+	};
+	mix(stride);
+	for (unsigned int i = 0; i < elementCount; i++) {
+		mix(elements[i].type);
+		mix(elements[i].count);
+		mix(elements[i].normalized);
+		mix(elements[i].offset);
+		mix(elements[i].divisor);
+	}
+	return hash;
+}
+
+/**
+* GL format of one component of a C++ type, only the types listed here can be pushed or used as vertex members.
+* unsigned char is normalized to [0, 1], colors being the usual use.
+**/
+template<typename T>
+struct VertexComponent
+{
+	static_assert(sizeof(T) == 0, "No vertex attribute format for this type");
 };
 
-class VertexBufferLayout 
+template<> struct VertexComponent<float> { static constexpr unsigned int type = GL_FLOAT; static constexpr unsigned char normalized = GL_FALSE; };
+template<> struct VertexComponent<unsigned int> { static constexpr unsigned int type = GL_UNSIGNED_INT; static constexpr unsigned char normalized = GL_FALSE; };
+template<> struct VertexComponent<unsigned char> { static constexpr unsigned int type = GL_UNSIGNED_BYTE; static constexpr unsigned char normalized = GL_TRUE; };
+template<> struct VertexComponent<Half> { static constexpr unsigned int type = GL_HALF_FLOAT; static constexpr unsigned char normalized = GL_FALSE; };
+template<> struct VertexComponent<SNorm16> { static constexpr unsigned int type = GL_SHORT; static constexpr unsigned char normalized = GL_TRUE; };
+template<> struct VertexComponent<SNorm1010102> { static constexpr unsigned int type = GL_INT_2_10_10_10_REV; static constexpr unsigned char normalized = GL_TRUE; };
+
+class VertexBufferLayout
 {
 	private:
 		std::vector<VertexBufferElement> m_Elements;
 		unsigned int m_Stride;
 
+		void Append(unsigned int type, unsigned int count, unsigned char normalized, unsigned int divisor) {
+			ASSERT(type != GL_INT_2_10_10_10_REV || count == 4);
+			ASSERT(m_Elements.empty() || m_Elements.front().divisor == divisor);
+			m_Elements.push_back({ type, count, normalized, m_Stride, divisor });
+			m_Stride += VertexBufferElement::GetSizeOfElement(type, count);
+		}
+
 	public:
 		VertexBufferLayout() : m_Stride(0) {}
 
+		// Appends count components of T, SNorm1010102 always takes 4
 		template<typename T>
 		void Push(unsigned int count) {
-			static_assert(false);
-		}
-	
-		template<>
-		void Push<float>(unsigned int count) {
-			m_Elements.push_back({GL_FLOAT, count, GL_FALSE });
-			m_Stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
+			Append(VertexComponent<T>::type, count, VertexComponent<T>::normalized, 0);
 		}
 
-		template<>
-		void Push<unsigned int>(unsigned int count) {
-			m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-			m_Stride += count * VertexBufferElement::GetSizeOfType(GL_INT);
-		}
-
-		template<>
-		void Push<unsigned char>(unsigned int count) {
-			m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-			m_Stride += count * VertexBufferElement::GetSizeOfType(GL_BYTE);
+		/**
+		* Appends count components of T read once per divisor instances instead of once per vertex.
+		* A layout is either per vertex or per instance with a single divisor: VertexArray::AddBuffer attaches
+		* instanced layouts as a second buffer, their attributes numbered after the per-vertex ones.
+		**/
+		template<typename T>
+		void PushInstanced(unsigned int count, unsigned int divisor = 1) {
+			ASSERT(divisor > 0);
+			Append(VertexComponent<T>::type, count, VertexComponent<T>::normalized, divisor);
 		}
 
-		inline const std::vector<VertexBufferElement> GetElements() const& { return m_Elements; }
+		inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
 		inline unsigned int GetStride() const { return m_Stride; }
-};
\ No newline at end of file
+};
+
+// Component type and count of a vertex struct member: a scalar, an array of them, or a packed 4 component word
+template<typename T>
+struct VertexAttribute
+{
+	using Component = T;
+	static constexpr unsigned int count = std::is_same<T, SNorm1010102>::value ? 4 : 1;
+};
+
+template<typename T, size_t N>
+struct VertexAttribute<T[N]>
+{
+	using Component = T;
+	static constexpr unsigned int count = N;
+};
+
+/**
+* Layout fixed at compile time, see MakeVertexLayout. Fixed size and allocation free,
+* VertexArray::AddBuffer reads it in place.
+**/
+template<size_t N>
+struct StaticVertexLayout
+{
+	VertexBufferElement elements[N];
+	unsigned int stride;
+
+	inline constexpr unsigned int GetCount() const { return (unsigned int)N; }
+};
+
+// The member pointer gives the attribute format, offsetof its position
+template<typename Vertex, typename Member>
+constexpr VertexBufferElement MakeVertexElement(Member Vertex::*, size_t offset)
+{
+	using Component = typename VertexAttribute<Member>::Component;
+	return { VertexComponent<Component>::type, VertexAttribute<Member>::count, VertexComponent<Component>::normalized, (unsigned int)offset, 0 };
+}
+
+#define VERTEX_ELEMENT(Vertex, member) MakeVertexElement(&Vertex::member, offsetof(Vertex, member))
+
+/**
+* Describes a vertex struct, attributes in the order given, stride being sizeof(Vertex):
+*   struct Vertex { float position[3]; unsigned char color[4]; };
+*   constexpr auto layout = MakeVertexLayout<Vertex>(VERTEX_ELEMENT(Vertex, position), VERTEX_ELEMENT(Vertex, color));
+**/
+template<typename Vertex, typename... Elements>
+constexpr StaticVertexLayout<sizeof...(Elements)> MakeVertexLayout(Elements... elements)
+{
+	static_assert(std::is_standard_layout<Vertex>::value, "offsetof needs a standard layout vertex");
+	return { { elements... }, (unsigned int)sizeof(Vertex) };
+}
+
+constexpr auto QuantizedVertexLayout = MakeVertexLayout<QuantizedVertex>(VERTEX_ELEMENT(QuantizedVertex, position),
+	VERTEX_ELEMENT(QuantizedVertex, normal), VERTEX_ELEMENT(QuantizedVertex, uv));
@@ -0,0 +1,263 @@
+#include "VertexEncoding.h"
+#include <cstring>
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// MSVC compiles AVX2 intrinsics in any function, GCC and Clang need the target enabled per function
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#define FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define TARGET_AVX2
+#define FORCE_INLINE __forceinline
+#endif
+
+static bool SupportsAVX2()
+{
+    unsigned int info[4] = {};
+#ifdef _MSC_VER
+    __cpuid((int*)info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid((int*)info, 1);
+#else
+    if (__get_cpuid_max(0, nullptr) < 7)
+        return false;
+    __cpuid(1, info[0], info[1], info[2], info[3]);
+#endif
+    // OSXSAVE, AVX and F16C
+    const unsigned int features = (1u << 27) | (1u << 28) | (1u << 29);
+    if ((info[2] & features) != features)
+        return false;
+
+    // The OS has to save the YMM registers on context switches
+#ifdef _MSC_VER
+    unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex((int*)info, 7, 0);
+#else
+    unsigned int xcr0Low, xcr0High;
+    __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    unsigned long long xcr0 = xcr0Low;
+    __cpuid_count(7, 0, info[0], info[1], info[2], info[3]);
+#endif
+    return (xcr0 & 6) == 6 && (info[1] & (1u << 5)) != 0;
+}
+
+static const bool s_SupportsAVX2 = SupportsAVX2();
+static SimdLevel s_SimdLevel = s_SupportsAVX2 ? SimdLevel::AVX2 : SimdLevel::SSE2;
+
+SimdLevel GetVertexEncoderSimd()
+{
+    return s_SimdLevel;
+}
+
+void SetVertexEncoderSimd(SimdLevel level)
+{
+    s_SimdLevel = level == SimdLevel::AVX2 && !s_SupportsAVX2 ? SimdLevel::SSE2 : level;
+}
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::AVX2: return "AVX2";
+        default:              return "SSE2";
+    }
+}
+
+/**
+* Round to nearest even float to half without F16C, 4 at a time. Results are sign extended to 32 bits so that
+* a signed saturating pack keeps them intact. (After Fabian Giesen's float_to_half_rtne_SSE2.)
+**/
+static inline __m128i FloatToHalfSSE2(__m128 f)
+{
+    const __m128i maxHalf = _mm_set1_epi32((127 + 16) << 23);		// this and above rounds to infinity
+    const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);		// below gives a subnormal half
+    const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+    __m128 sign = _mm_and_ps(f, _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000)));
+    __m128 absolute = _mm_xor_ps(f, sign);
+    __m128i bits = _mm_castps_si128(absolute);
+    __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+    __m128i isFinite = _mm_cmpgt_epi32(maxHalf, bits);
+    __m128i infinityOrNaN = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+    // Subnormals: the float adder aligns and rounds the mantissa for us
+    __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, bits);
+    __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+    // Normals: rebias the exponent, add half an ulp minus one, plus one more if the kept mantissa is odd
+    __m128i odd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+    __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(bits, normalBias), odd), 13);
+
+    __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    __m128i result = _mm_or_si128(_mm_and_si128(isFinite, finite), _mm_andnot_si128(isFinite, infinityOrNaN));
+    return _mm_or_si128(result, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+static inline __m128i ToSNorm(__m128 f, float scale)
+{
+    f = _mm_min_ps(_mm_max_ps(f, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+    return _mm_cvtps_epi32(_mm_mul_ps(f, _mm_set1_ps(scale)));
+}
+
+static inline __m128i PackSNorm1010102(__m128 x, __m128 y, __m128 z)
+{
+    const __m128i mask = _mm_set1_epi32(0x3FF);
+    __m128i packed = _mm_and_si128(ToSNorm(x, 511.0f), mask);
+    packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_and_si128(ToSNorm(y, 511.0f), mask), 10));
+    return _mm_or_si128(packed, _mm_slli_epi32(_mm_and_si128(ToSNorm(z, 511.0f), mask), 20));
+}
+
+// Kernels encode one block of Width floats (or Width xyz triplets) at a time
+struct HalfSSE2
+{
+    static const size_t Width = 4, Inputs = 4, Outputs = 4;
+    static inline void Encode(Half* destination, const float* source)
+    {
+        __m128i h = FloatToHalfSSE2(_mm_loadu_ps(source));
+        _mm_storel_epi64((__m128i*)destination, _mm_packs_epi32(h, h));
+    }
+};
+
+struct HalfAVX2
+{
+    static const size_t Width = 8, Inputs = 8, Outputs = 8;
+    static inline TARGET_AVX2 void Encode(Half* destination, const float* source)
+    {
+        _mm_storeu_si128((__m128i*)destination, _mm256_cvtps_ph(_mm256_loadu_ps(source), _MM_FROUND_TO_NEAREST_INT));
+    }
+};
+
+struct SNorm16SSE2
+{
+    static const size_t Width = 4, Inputs = 4, Outputs = 4;
+    static inline void Encode(SNorm16* destination, const float* source)
+    {
+        __m128i s = ToSNorm(_mm_loadu_ps(source), 32767.0f);
+        _mm_storel_epi64((__m128i*)destination, _mm_packs_epi32(s, s));
+    }
+};
+
+struct SNorm16AVX2
+{
+    static const size_t Width = 8, Inputs = 8, Outputs = 8;
+    static inline TARGET_AVX2 void Encode(SNorm16* destination, const float* source)
+    {
+        __m256 f = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(source), _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+        __m256i s = _mm256_cvtps_epi32(_mm256_mul_ps(f, _mm256_set1_ps(32767.0f)));
+        _mm_storeu_si128((__m128i*)destination, _mm_packs_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1)));
+    }
+};
+
+struct SNorm1010102SSE2
+{
+    static const size_t Width = 4, Inputs = 12, Outputs = 4;
+    static inline void Encode(SNorm1010102* destination, const float* s)
+    {
+        __m128 x = _mm_set_ps(s[9], s[6], s[3], s[0]);
+        __m128 y = _mm_set_ps(s[10], s[7], s[4], s[1]);
+        __m128 z = _mm_set_ps(s[11], s[8], s[5], s[2]);
+        _mm_storeu_si128((__m128i*)destination, PackSNorm1010102(x, y, z));
+    }
+};
+
+struct SNorm1010102AVX2
+{
+    static const size_t Width = 8, Inputs = 24, Outputs = 8;
+    static inline TARGET_AVX2 void Encode(SNorm1010102* destination, const float* source)
+    {
+        const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+        const __m256i mask = _mm256_set1_epi32(0x3FF);
+        __m256i packed = _mm256_setzero_si256();
+        for (int axis = 0; axis < 3; axis++) {
+            __m256 f = _mm256_i32gather_ps(source + axis, stride, 4);
+            f = _mm256_min_ps(_mm256_max_ps(f, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+            __m256i s = _mm256_and_si256(_mm256_cvtps_epi32(_mm256_mul_ps(f, _mm256_set1_ps(511.0f))), mask);
+            packed = _mm256_or_si256(packed, _mm256_sllv_epi32(s, _mm256_set1_epi32(axis * 10)));
+        }
+        _mm256_storeu_si256((__m256i*)destination, packed);
+    }
+};
+
+/**
+* Whole blocks straight from the source, the remainder through zero padded scratch so the kernel never reads past the end
+* Always inlined: compiled on its own it couldn't inline an AVX2 kernel, which would then be called once per block
+**/
+template<typename Kernel, typename T>
+static FORCE_INLINE void EncodeBlocks(T* destination, const float* source, size_t count)
+{
+    size_t blocks = count / Kernel::Width;
+    for (size_t i = 0; i < blocks; i++)
+        Kernel::Encode(destination + i * Kernel::Outputs, source + i * Kernel::Inputs);
+
+    size_t remaining = count - blocks * Kernel::Width;
+    if (remaining) {
+        float input[Kernel::Inputs] = {};
+        T output[Kernel::Outputs];
+        size_t inputsPerItem = Kernel::Inputs / Kernel::Width;
+        memcpy(input, source + blocks * Kernel::Inputs, remaining * inputsPerItem * sizeof(float));
+        Kernel::Encode(output, input);
+        memcpy(destination + blocks * Kernel::Outputs, output, remaining * sizeof(T));
+    }
+}
+
+// The AVX2 loop needs the target too, GCC and Clang only inline a target("avx2") kernel into a caller that has it
+template<typename Kernel, typename T>
+static TARGET_AVX2 void EncodeBlocksAVX2(T* destination, const float* source, size_t count)
+{
+    EncodeBlocks<Kernel>(destination, source, count);
+}
+
+void EncodeHalf(Half* destination, const float* source, size_t count)
+{
+    if (s_SimdLevel == SimdLevel::AVX2)
+        EncodeBlocksAVX2<HalfAVX2>(destination, source, count);
+    else
+        EncodeBlocks<HalfSSE2>(destination, source, count);
+}
+
+void EncodeSNorm16(SNorm16* destination, const float* source, size_t count)
+{
+    if (s_SimdLevel == SimdLevel::AVX2)
+        EncodeBlocksAVX2<SNorm16AVX2>(destination, source, count);
+    else
+        EncodeBlocks<SNorm16SSE2>(destination, source, count);
+}
+
+void EncodeSNorm1010102(SNorm1010102* destination, const float* source, size_t count)
+{
+    if (s_SimdLevel == SimdLevel::AVX2)
+        EncodeBlocksAVX2<SNorm1010102AVX2>(destination, source, count);
+    else
+        EncodeBlocks<SNorm1010102SSE2>(destination, source, count);
+}
+
+void QuantizeVertices(QuantizedVertex* destination, const float* positions, const float* normals, const float* uvs, size_t count)
+{
+    // Encode a chunk of each stream into scratch that stays in L1, then interleave
+    const size_t Chunk = 256;
+    Half position[Chunk * 3];
+    SNorm1010102 normal[Chunk];
+    Half uv[Chunk * 2];
+    const Half one = { 0x3C00 };
+
+    for (size_t begin = 0; begin < count; begin += Chunk) {
+        size_t n = count - begin < Chunk ? count - begin : Chunk;
+        EncodeHalf(position, positions + begin * 3, n * 3);
+        EncodeSNorm1010102(normal, normals + begin * 3, n);
+        EncodeHalf(uv, uvs + begin * 2, n * 2);
+        for (size_t i = 0; i < n; i++) {
+            QuantizedVertex& vertex = destination[begin + i];
+            memcpy(vertex.position, &position[i * 3], 3 * sizeof(Half));
+            vertex.position[3] = one;
+            vertex.normal = normal[i];
+            memcpy(vertex.uv, &uv[i * 2], 2 * sizeof(Half));
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Storage types for quantized attributes, pushed into a VertexBufferLayout like the plain ones:
+*   Half         - GL_HALF_FLOAT, 2 bytes per component
+*   SNorm16      - normalized GL_SHORT, [-1, 1] in 2 bytes per component
+*   SNorm1010102 - normalized GL_INT_2_10_10_10_REV, xyz in 10 bits each plus a 2-bit w, always 4 components in 4 bytes
+**/
+struct Half { uint16_t bits; };
+struct SNorm16 { int16_t value; };
+struct SNorm1010102 { uint32_t bits; };
+
+enum class SimdLevel
+{
+	SSE2,
+	AVX2	// AVX2 with F16C, picked at startup when the CPU supports both
+};
+
+SimdLevel GetVertexEncoderSimd();
+// Forces a path, e.g. to compare them. Asking for more than the CPU supports keeps the best available.
+void SetVertexEncoderSimd(SimdLevel level);
+const char* GetSimdLevelName(SimdLevel level);
+
+/**
+* Bulk encoders from tightly packed floats, count is the number of floats for EncodeHalf/EncodeSNorm16
+* and the number of xyz triplets for EncodeSNorm1010102 (w is written as 0).
+* Rounding is to nearest even, normalized formats clamp to [-1, 1].
+**/
+void EncodeHalf(Half* destination, const float* source, size_t count);
+void EncodeSNorm16(SNorm16* destination, const float* source, size_t count);
+void EncodeSNorm1010102(SNorm1010102* destination, const float* source, size_t count);
+
+/**
+* 16 byte vertex, half the size of the float position/normal/uv vertex it encodes. Its layout is
+*   Push<Half>(4), Push<SNorm1010102>(4), Push<Half>(2)
+* Position w is 1, positions keep about 3 significant digits so large meshes should be stored relative to their center.
+**/
+struct QuantizedVertex
+{
+	Half position[4];
+	SNorm1010102 normal;
+	Half uv[2];
+};
+
+// positions and normals are xyz triplets, uvs pairs, all count vertices long
+void QuantizeVertices(QuantizedVertex* destination, const float* positions, const float* normals, const float* uvs, size_t count);
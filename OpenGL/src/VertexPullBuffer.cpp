@@ -0,0 +1,138 @@
+#include "VertexPullBuffer.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "GLCaps.h"
+#include "IndexBuffer.h"
+
+const char* GetVertexPullSourceName(VertexPullSource source)
+{
+    return source == VertexPullSource::StorageBuffer ? "storage buffer" : "texture buffer";
+}
+
+// Buffer texture reading buffer as texels of format, created on unit 0
+static unsigned int CreateBufferTexture(unsigned int format, unsigned int buffer)
+{
+    unsigned int texture;
+    GLCall(glGenTextures(1, &texture));
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_BUFFER, texture);
+    GLCall(glTexBuffer(GL_TEXTURE_BUFFER, format, buffer));
+    return texture;
+}
+
+VertexPullBuffer::VertexPullBuffer(unsigned int capacity)
+    : m_Source(GLCaps::Get().shaderStorageBuffer ? VertexPullSource::StorageBuffer : VertexPullSource::TextureBuffer),
+      m_Data(nullptr, capacity / 4 * 4, BufferUsage::Dynamic),
+      m_Meshes(nullptr, MaxMeshes * (unsigned int)sizeof(Mesh), BufferUsage::Dynamic),
+      m_DataTexture(0), m_MeshTexture(0), m_UsedWords(0)
+{
+    if (m_Source == VertexPullSource::TextureBuffer) {
+        m_DataTexture = CreateBufferTexture(GL_R32UI, m_Data.GetRendererID());
+        m_MeshTexture = CreateBufferTexture(GL_RGBA32UI, m_Meshes.GetRendererID());
+    }
+}
+
+VertexPullBuffer::~VertexPullBuffer()
+{
+    GLStateCache& state = GLStateCache::Get();
+    for (unsigned int texture : { m_DataTexture, m_MeshTexture }) {
+        if (texture) {
+            GLCall(glDeleteTextures(1, &texture));
+            state.OnDeleteTexture(texture);
+        }
+    }
+}
+
+unsigned int VertexPullBuffer::AddMesh(const void* vertices, unsigned int vertexCount, unsigned int stride, unsigned int userData)
+{
+    ASSERT(stride % 4 == 0 && vertexCount <= MaxMeshVertices);
+    // In 64 bits, a large mesh times a wide stride wraps around 32 and would pass the size check
+    const uint64_t words = (uint64_t)vertexCount * (stride / 4);
+    if (m_MeshList.size() == MaxMeshes || (m_UsedWords + words) * 4 > m_Data.GetSize())
+        return InvalidMesh;
+
+    unsigned int id = (unsigned int)m_MeshList.size();
+    Mesh mesh = { m_UsedWords, stride / 4, vertexCount, userData };
+    m_Data.Update(vertices, (unsigned int)words * 4, m_UsedWords * 4);
+    m_Meshes.Update(&mesh, sizeof(Mesh), id * (unsigned int)sizeof(Mesh));
+    m_MeshList.push_back(mesh);
+    m_UsedWords += (unsigned int)words;
+    return id;
+}
+
+void VertexPullBuffer::EncodeIndices(unsigned int mesh, const unsigned int* indices, unsigned int count, unsigned int* output) const
+{
+    ASSERT(mesh < m_MeshList.size());
+    const unsigned int meshBits = mesh << VertexBits;
+    for (unsigned int i = 0; i < count; i++) {
+        ASSERT(indices[i] == 0xFFFFFFFF || indices[i] < m_MeshList[mesh].vertexCount);
+        output[i] = indices[i] == 0xFFFFFFFF ? indices[i] : (meshBits | indices[i]);
+    }
+}
+
+void VertexPullBuffer::SetIndexBuffer(const IndexBuffer& ib)
+{
+    m_VertexArray.SetIndexBuffer(ib);
+}
+
+void VertexPullBuffer::Bind(unsigned int slot) const
+{
+    GLStateCache& state = GLStateCache::Get();
+    if (m_Source == VertexPullSource::StorageBuffer) {
+        state.BindStorageBuffer(slot, m_Data.GetRendererID());
+        state.BindStorageBuffer(slot + 1, m_Meshes.GetRendererID());
+    }
+    else {
+        state.BindTexture(slot, GL_TEXTURE_BUFFER, m_DataTexture);
+        state.BindTexture(slot + 1, GL_TEXTURE_BUFFER, m_MeshTexture);
+    }
+}
+
+void VertexPullBuffer::SetupProgram(unsigned int program, unsigned int slot) const
+{
+    if (m_Source == VertexPullSource::StorageBuffer)
+        return;
+    // Sampler units are program state, set once after linking
+    GLStateCache::Get().UseProgram(program);
+    GLCall(int data = glGetUniformLocation(program, "u_PullData"));
+    GLCall(int meshes = glGetUniformLocation(program, "u_PullMeshes"));
+    GLCall(glUniform1i(data, (int)slot));
+    GLCall(glUniform1i(meshes, (int)slot + 1));
+}
+
+void VertexPullBuffer::Clear()
+{
+    m_MeshList.clear();
+    m_UsedWords = 0;
+}
+
+std::string VertexPullBuffer::GetShaderPrologue(VertexPullSource source, unsigned int slot)
+{
+    std::string prologue;
+    if (source == VertexPullSource::StorageBuffer) {
+        prologue =
+            "#version 430 core\n"
+            "layout(std430, binding = " + std::to_string(slot) + ") readonly buffer PullData { uint u_PullData[]; };\n"
+            "layout(std430, binding = " + std::to_string(slot + 1) + ") readonly buffer PullMeshes { uvec4 u_PullMeshes[]; };\n"
+            "uint PullWord(uint word) { return u_PullData[word]; }\n"
+            "uvec4 PullMeshEntry(uint mesh) { return u_PullMeshes[mesh]; }\n";
+    }
+    else {
+        prologue =
+            "#version 330 core\n"
+            "uniform usamplerBuffer u_PullData;\n"
+            "uniform usamplerBuffer u_PullMeshes;\n"
+            "uint PullWord(uint word) { return texelFetch(u_PullData, int(word)).r; }\n"
+            "uvec4 PullMeshEntry(uint mesh) { return texelFetch(u_PullMeshes, int(mesh)); }\n";
+    }
+    const std::string vertexBits = std::to_string(VertexBits) + "u";
+    const std::string vertexMask = std::to_string(MaxMeshVertices - 1) + "u";
+    prologue +=
+        "// x first word, y stride in words, z vertex count, w user data\n"
+        "uvec4 PullMesh() { return PullMeshEntry(uint(gl_VertexID) >> " + vertexBits + "); }\n"
+        "uint PullVertex(uvec4 mesh) { return mesh.x + (uint(gl_VertexID) & " + vertexMask + ") * mesh.y; }\n"
+        "float PullFloat(uint word) { return uintBitsToFloat(PullWord(word)); }\n"
+        "vec2 PullVec2(uint word) { return vec2(PullFloat(word), PullFloat(word + 1u)); }\n"
+        "vec3 PullVec3(uint word) { return vec3(PullFloat(word), PullFloat(word + 1u), PullFloat(word + 2u)); }\n"
+        "vec4 PullVec4(uint word) { return vec4(PullVec3(word), PullFloat(word + 3u)); }\n";
+    return prologue;
+}
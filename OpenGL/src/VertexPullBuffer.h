@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+class IndexBuffer;
+
+/**
+* Where the pulled vertex data is read from in the shader
+*   TextureBuffer - usamplerBuffer and texelFetch, any GL 3.3 context
+*   StorageBuffer - std430 shader storage buffer, GL 4.3
+**/
+enum class VertexPullSource
+{
+	TextureBuffer,
+	StorageBuffer
+};
+
+const char* GetVertexPullSourceName(VertexPullSource source);
+
+/**
+* Vertex data of many meshes packed as 32-bit words into one buffer that the vertex shader fetches itself
+* (programmable vertex pulling) instead of going through attributes. Every mesh is drawn with the same
+* attribute-less vertex array and may have any layout: the shader gets its first word and stride from a
+* per-mesh table, so meshes with different layouts can share one index buffer and even one draw.
+*
+* Pulled indices encode the mesh in their top bits: (mesh << VertexBits) | vertex, which the shader splits
+* from gl_VertexID. Draw them without a base vertex. The shader source starts with GetShaderPrologue().
+* Meshes are appended until the buffer is full, Clear starts over.
+**/
+class VertexPullBuffer
+{
+	public:
+		static const unsigned int VertexBits = 20;
+		static const unsigned int MaxMeshVertices = 1 << VertexBits;
+		// The last id is left out so no pulled index collides with the 32-bit restart index
+		static const unsigned int MaxMeshes = (1 << (32 - VertexBits)) - 1;
+		static const unsigned int InvalidMesh = 0xFFFFFFFF;
+
+		// One entry of the mesh table, read as a uvec4 by the shader
+		struct Mesh
+		{
+			unsigned int firstWord;
+			unsigned int strideWords;
+			unsigned int vertexCount;
+			unsigned int userData;	// free for the shader, e.g. which of a few layouts the mesh uses
+		};
+
+	private:
+		VertexPullSource m_Source;
+		VertexBuffer m_Data;
+		VertexBuffer m_Meshes;
+		unsigned int m_DataTexture;		// buffer textures over m_Data and m_Meshes, TextureBuffer source only
+		unsigned int m_MeshTexture;
+		unsigned int m_UsedWords;
+		std::vector<Mesh> m_MeshList;
+		VertexArray m_VertexArray;		// no attributes, only the element buffer
+
+	public:
+		/**
+		* capacity - bytes of vertex data, the TextureBuffer source is further limited to
+		* GL_MAX_TEXTURE_BUFFER_SIZE words (at least 64K, typically 128M or more)
+		* The source is StorageBuffer when the context has shader storage buffers
+		**/
+		explicit VertexPullBuffer(unsigned int capacity);
+		~VertexPullBuffer();
+
+		VertexPullBuffer(const VertexPullBuffer&) = delete;
+		VertexPullBuffer& operator=(const VertexPullBuffer&) = delete;
+
+		/**
+		* Copies vertexCount vertices of stride bytes (a multiple of 4) and returns the mesh id,
+		* InvalidMesh when the buffer or the mesh table is full
+		**/
+		unsigned int AddMesh(const void* vertices, unsigned int vertexCount, unsigned int stride, unsigned int userData = 0);
+
+		// Writes the pulled form of mesh-local indices to output, restart indices (0xFFFFFFFF) are kept
+		void EncodeIndices(unsigned int mesh, const unsigned int* indices, unsigned int count, unsigned int* output) const;
+
+		// Attaches the index buffer every pulled draw uses to the shared vertex array
+		void SetIndexBuffer(const IndexBuffer& ib);
+
+		/**
+		* Makes the data visible to shaders built from GetShaderPrologue(slot): texture units slot and slot + 1,
+		* or storage buffer bindings slot and slot + 1. Texture unit bindings are global state, call before drawing.
+		**/
+		void Bind(unsigned int slot = 0) const;
+
+		// Points the sampler uniforms of a linked program at the texture units, nothing to do for storage buffers
+		void SetupProgram(unsigned int program, unsigned int slot = 0) const;
+
+		// Drops every mesh, ids and pulled indices handed out before are invalid afterwards
+		void Clear();
+
+		/**
+		* GLSL to start the vertex shader with, #version line included. Declares
+		*   uvec4 PullMesh()          - table entry of the vertex being shaded
+		*   uint  PullVertex(mesh)    - its first word
+		*   uint  PullWord(word), float PullFloat(word), vec2/vec3/vec4 PullVec2/3/4(word)
+		* so reading a position stored first is PullVec3(PullVertex(PullMesh()))
+		**/
+		static std::string GetShaderPrologue(VertexPullSource source, unsigned int slot = 0);
+
+		inline const VertexArray& GetVertexArray() const { return m_VertexArray; }
+		inline VertexPullSource GetSource() const { return m_Source; }
+		inline unsigned int GetMeshCount() const { return (unsigned int)m_MeshList.size(); }
+		inline const Mesh& GetMesh(unsigned int mesh) const { return m_MeshList[mesh]; }
+		inline unsigned int GetUsedBytes() const { return m_UsedWords * 4; }
+};
@@ -0,0 +1,69 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+    : m_Task(nullptr), m_TaskCount(0), m_NextTask(0), m_BusyWorkers(0), m_Generation(0), m_Quit(false)
+{
+    for (unsigned int i = 0; i < threadCount; i++)
+        m_Threads.emplace_back(&WorkerPool::WorkerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_WakeWorkers.notify_all();
+    for (std::thread& thread : m_Threads)
+        thread.join();
+}
+
+// Grabs task indices until there are none left, shared by the workers and the calling thread
+void WorkerPool::RunTasks()
+{
+    unsigned int task;
+    while ((task = m_NextTask.fetch_add(1, std::memory_order_relaxed)) < m_TaskCount)
+        (*m_Task)(task);
+}
+
+void WorkerPool::WorkerLoop()
+{
+    unsigned int generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WakeWorkers.wait(lock, [&]() { return m_Quit || m_Generation != generation; });
+            if (m_Quit)
+                return;
+            generation = m_Generation;
+        }
+
+        RunTasks();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--m_BusyWorkers == 0)
+            m_WorkDone.notify_one();
+    }
+}
+
+void WorkerPool::ParallelFor(unsigned int taskCount, const std::function<void(unsigned int)>& task)
+{
+    if (taskCount == 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Task = &task;
+        m_TaskCount = taskCount;
+        m_NextTask.store(0, std::memory_order_relaxed);
+        m_BusyWorkers = (unsigned int)m_Threads.size();
+        m_Generation++;
+    }
+    m_WakeWorkers.notify_all();
+
+    RunTasks();
+
+    // Workers must be done with m_Task before it goes out of scope in the caller
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_WorkDone.wait(lock, [&]() { return m_BusyWorkers == 0; });
+}
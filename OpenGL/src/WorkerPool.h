@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* Persistent worker threads for CPU side frame work such as recording command lists.
+* Workers never touch GL, they have no context.
+**/
+class WorkerPool
+{
+	private:
+		std::vector<std::thread> m_Threads;
+		std::mutex m_Mutex;
+		std::condition_variable m_WakeWorkers;
+		std::condition_variable m_WorkDone;
+
+		const std::function<void(unsigned int)>* m_Task;
+		unsigned int m_TaskCount;
+		std::atomic<unsigned int> m_NextTask;
+		unsigned int m_BusyWorkers;
+		unsigned int m_Generation;
+		bool m_Quit;
+
+		void WorkerLoop();
+		void RunTasks();
+
+	public:
+		// Defaults to one worker per core besides the calling thread
+		explicit WorkerPool(unsigned int threadCount = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1);
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		/**
+		* Runs task(i) for every i in [0, taskCount) on the workers and the calling thread
+		* Returns once every task has finished
+		**/
+		void ParallelFor(unsigned int taskCount, const std::function<void(unsigned int)>& task);
+
+		// Workers plus the calling thread
+		inline unsigned int GetConcurrency() const { return (unsigned int)m_Threads.size() + 1; }
+};